@@ -49,6 +49,7 @@
 #include "gstomx_ilbcdec.h"
 #include "gstomx_ilbcenc.h"
 #include "gstomx_jpegenc.h"
+#include "gstomx_multichannel.h"
 #endif /* EXPERIMENTAL */
 #include "gstomx_audiosink.h"
 #ifdef EXPERIMENTAL
@@ -97,6 +98,7 @@ static TableItem element_table[] =
     { "omx_ilbcdec", "libomxil-bellagio.so.0", "OMX.st.audio_decoder.ilbc", GST_RANK_PRIMARY, gst_omx_ilbcdec_get_type },
     { "omx_ilbcenc", "libomxil-bellagio.so.0", "OMX.st.audio_encoder.ilbc", GST_RANK_PRIMARY, gst_omx_ilbcenc_get_type },
     { "omx_jpegenc", "libomxil-bellagio.so.0", "OMX.st.image_encoder.jpeg", GST_RANK_PRIMARY, gst_omx_jpegenc_get_type },
+    { "omx_multichannel", "libomxil-bellagio.so.0", "OMX.st.audio_decoder.g711", GST_RANK_NONE, gst_omx_multichannel_get_type },
 #endif /* EXPERIMENTAL */
     { "omx_audiosink", "libomxil-bellagio.so.0", "OMX.st.alsa.alsasink", GST_RANK_NONE, gst_omx_audiosink_get_type },
 #ifdef EXPERIMENTAL
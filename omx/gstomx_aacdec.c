@@ -20,12 +20,9 @@
  */
 
 #include "gstomx_aacdec.h"
-#include "gstomx_base_filter.h"
 #include "gstomx.h"
 
-#include <string.h> /* for memset */
-
-static GstOmxBaseFilterClass *parent_class;
+static GstOmxBaseAudioDecClass *parent_class;
 
 static GstCaps *
 generate_src_template (void)
@@ -41,7 +38,7 @@ generate_src_template (void)
                                 "channels", GST_TYPE_INT_RANGE, 1, 6,
                                 NULL);
 
-    return caps;
+    return g_omx_convert_pcm_caps (caps);
 }
 
 static GstCaps *
@@ -127,50 +124,7 @@ static void
 type_class_init (gpointer g_class,
                  gpointer class_data)
 {
-    parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
-}
-
-static void
-settings_changed_cb (GOmxCore *core)
-{
-    GstOmxBaseFilter *omx_base;
-    guint rate;
-    guint channels;
-
-    omx_base = core->object;
-
-    GST_DEBUG_OBJECT (omx_base, "settings changed");
-
-    {
-        OMX_AUDIO_PARAM_PCMMODETYPE param;
-
-        memset (&param, 0, sizeof (param));
-        param.nSize = sizeof (OMX_AUDIO_PARAM_PCMMODETYPE);
-        param.nVersion.s.nVersionMajor = 1;
-        param.nVersion.s.nVersionMinor = 1;
-
-        param.nPortIndex = 1;
-        OMX_GetParameter (omx_base->gomx->omx_handle, OMX_IndexParamAudioPcm, &param);
-
-        rate = param.nSamplingRate;
-        channels = param.nChannels;
-    }
-
-    {
-        GstCaps *new_caps;
-
-        new_caps = gst_caps_new_simple ("audio/x-raw-int",
-                                        "width", G_TYPE_INT, 16,
-                                        "depth", G_TYPE_INT, 16,
-                                        "rate", G_TYPE_INT, rate,
-                                        "signed", G_TYPE_BOOLEAN, TRUE,
-                                        "endianness", G_TYPE_INT, G_BYTE_ORDER,
-                                        "channels", G_TYPE_INT, channels,
-                                        NULL);
-
-        GST_INFO_OBJECT (omx_base, "caps are: %" GST_PTR_FORMAT, new_caps);
-        gst_pad_set_caps (omx_base->srcpad, new_caps);
-    }
+    parent_class = g_type_class_ref (GST_OMX_BASE_AUDIODEC_TYPE);
 }
 
 static gboolean
@@ -210,8 +164,6 @@ type_instance_init (GTypeInstance *instance,
 
     omx_base = GST_OMX_BASE_FILTER (instance);
 
-    omx_base->gomx->settings_changed_cb = settings_changed_cb;
-
     gst_pad_set_setcaps_function (omx_base->sinkpad, sink_setcaps);
 }
 
@@ -231,7 +183,7 @@ gst_omx_aacdec_get_type (void)
         type_info->instance_size = sizeof (GstOmxAacDec);
         type_info->instance_init = type_instance_init;
 
-        type = g_type_register_static (GST_OMX_BASE_FILTER_TYPE, "GstOmxAacDec", type_info, 0);
+        type = g_type_register_static (GST_OMX_BASE_AUDIODEC_TYPE, "GstOmxAacDec", type_info, 0);
 
         g_free (type_info);
     }
@@ -21,9 +21,10 @@
 
 #include "gstomx_aacenc.h"
 #include "gstomx_base_filter.h"
+#include "gstomx_convert.h"
 #include "gstomx.h"
 
-#include <string.h> /* for memset */
+#include <string.h> /* for memset, memcpy */
 
 enum
 {
@@ -278,17 +279,127 @@ type_class_init (gpointer g_class,
     }
 }
 
+/* Into the component's channel order, as the data goes in. */
+static void
+in_copy (GstOmxBaseFilter *omx_base,
+         guint8 *dest,
+         GstBuffer *buf,
+         guint offset,
+         guint size)
+{
+    static const GOmxPcmFormat format = { GOMX_PCM_S16, G_BYTE_ORDER, FALSE };
+    GstOmxAacEnc *self;
+    guint frame_size;
+
+    self = GST_OMX_AACENC (omx_base);
+
+    frame_size = self->channels * 2;
+
+    /* pad_chain and in_slice_size leave no partial frame */
+    g_omx_convert_pcm (GST_BUFFER_DATA (buf) + offset, &format,
+                       dest, &format,
+                       self->channels, size / frame_size, self->channel_map);
+}
+
+/* Reordering needs whole frames; a frame split between two buffers is
+ * put back together before the data goes on. */
+static GstFlowReturn
+pad_chain (GstPad *pad,
+           GstBuffer *buf)
+{
+    GstOmxAacEnc *self;
+    GstBuffer *whole;
+    guint frame_size;
+    guint total;
+    guint size;
+    guint tail;
+
+    self = GST_OMX_AACENC (GST_OBJECT_PARENT (pad));
+
+    if (!GST_OMX_BASE_FILTER (self)->in_copy)
+        return self->base_chain (pad, buf);
+
+    frame_size = self->channels * 2;
+    total = self->partial_size + GST_BUFFER_SIZE (buf);
+    size = total - total % frame_size;
+    tail = total - size;
+
+    if (self->partial_size == 0 && tail == 0)
+        return self->base_chain (pad, buf);
+
+    if (size == 0)
+    {
+        memcpy (self->partial + self->partial_size, GST_BUFFER_DATA (buf), GST_BUFFER_SIZE (buf));
+        self->partial_size = tail;
+        gst_buffer_unref (buf);
+        return GST_FLOW_OK;
+    }
+
+    /* the timestamp is off by less than a sample */
+    whole = gst_buffer_new_and_alloc (size);
+    gst_buffer_copy_metadata (whole, buf,
+                              GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS | GST_BUFFER_COPY_CAPS);
+    GST_BUFFER_DURATION (whole) = GST_CLOCK_TIME_NONE;
+
+    memcpy (GST_BUFFER_DATA (whole), self->partial, self->partial_size);
+    memcpy (GST_BUFFER_DATA (whole) + self->partial_size, GST_BUFFER_DATA (buf),
+            size - self->partial_size);
+
+    memcpy (self->partial, GST_BUFFER_DATA (buf) + GST_BUFFER_SIZE (buf) - tail, tail);
+    self->partial_size = tail;
+
+    gst_buffer_unref (buf);
+
+    return self->base_chain (pad, whole);
+}
+
+static gboolean
+sink_event (GstPad *pad,
+            GstEvent *event)
+{
+    GstOmxAacEnc *self;
+
+    self = GST_OMX_AACENC (GST_OBJECT_PARENT (pad));
+
+    /* less than a sample; nothing to encode */
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS ||
+        GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+        self->partial_size = 0;
+
+    return self->base_sink_event (pad, event);
+}
+
+/* Only whole frames in each buffer, so they can be reordered. */
+static guint
+frame_aligned_size (GOmxCore *gomx,
+                    guint frame_size)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+
+    memset (&param, 0, sizeof (param));
+    param.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+    param.nVersion.s.nVersionMajor = 1;
+    param.nVersion.s.nVersionMinor = 1;
+
+    param.nPortIndex = 0;
+    OMX_GetParameter (gomx->omx_handle, OMX_IndexParamPortDefinition, &param);
+
+    return param.nBufferSize - param.nBufferSize % frame_size;
+}
+
 static gboolean
 sink_setcaps (GstPad *pad,
               GstCaps *caps)
 {
     GstStructure *structure;
     GstOmxBaseFilter *omx_base;
+    GstOmxAacEnc *self;
     GOmxCore *gomx;
     gint rate = 0;
     gint channels = 0;
 
     omx_base = GST_OMX_BASE_FILTER (GST_PAD_PARENT (pad));
+    self = GST_OMX_AACENC (omx_base);
     gomx = (GOmxCore *) omx_base->gomx;
 
     GST_INFO_OBJECT (omx_base, "setcaps (sink): %" GST_PTR_FORMAT, caps);
@@ -303,6 +414,15 @@ sink_setcaps (GstPad *pad,
     /* Input port configuration. */
     {
         OMX_AUDIO_PARAM_PCMMODETYPE param;
+        OMX_AUDIO_CHANNELTYPE mapping[OMX_AUDIO_MAXCHANNELS];
+
+        if (channels <= 0 || channels > OMX_AUDIO_MAXCHANNELS)
+        {
+            GST_WARNING_OBJECT (self, "unsupported channel count: %d", channels);
+            return FALSE;
+        }
+
+        g_omx_convert_channels_from_caps (structure, channels, mapping);
 
         memset (&param, 0, sizeof (param));
         param.nSize = sizeof (OMX_AUDIO_PARAM_PCMMODETYPE);
@@ -314,8 +434,25 @@ sink_setcaps (GstPad *pad,
 
         param.nSamplingRate = rate;
         param.nChannels = channels;
+        memcpy (param.eChannelMapping, mapping, channels * sizeof (mapping[0]));
 
         OMX_SetParameter (gomx->omx_handle, OMX_IndexParamAudioPcm, &param);
+
+        /* a component with its own order says so here */
+        OMX_GetParameter (gomx->omx_handle, OMX_IndexParamAudioPcm, &param);
+
+        self->channels = channels;
+        self->partial_size = 0;
+        omx_base->in_copy = NULL;
+        omx_base->in_slice_size = 0;
+
+        if (param.eChannelMapping[0] != OMX_AUDIO_ChannelNone &&
+            g_omx_convert_channel_map (mapping, param.eChannelMapping, channels, self->channel_map))
+        {
+            GST_INFO_OBJECT (omx_base, "reordering channels");
+            omx_base->in_copy = in_copy;
+            omx_base->in_slice_size = frame_aligned_size (gomx, channels * 2);
+        }
     }
 
     {
@@ -426,6 +563,12 @@ type_instance_init (GTypeInstance *instance,
 
     gst_pad_set_setcaps_function (omx_base->sinkpad, sink_setcaps);
 
+    self->base_chain = GST_PAD_CHAINFUNC (omx_base->sinkpad);
+    gst_pad_set_chain_function (omx_base->sinkpad, pad_chain);
+
+    self->base_sink_event = GST_PAD_EVENTFUNC (omx_base->sinkpad);
+    gst_pad_set_event_function (omx_base->sinkpad, sink_event);
+
     self->bitrate = DEFAULT_BITRATE;
     self->profile = DEFAULT_PROFILE;
     self->output_format = DEFAULT_OUTPUT_FORMAT;
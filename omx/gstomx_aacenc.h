@@ -40,6 +40,14 @@ struct GstOmxAacEnc
     guint bitrate;
     gint profile;
     gint output_format;
+
+    /* Input reordering, when the component has its own channel order. */
+    guint channels;
+    guint channel_map[OMX_AUDIO_MAXCHANNELS];
+    guint8 partial[OMX_AUDIO_MAXCHANNELS * 2]; /**< Start of a frame split between buffers */
+    guint partial_size;
+    GstPadChainFunction base_chain;
+    GstPadEventFunction base_sink_event;
 };
 
 struct GstOmxAacEncClass
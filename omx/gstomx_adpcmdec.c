@@ -20,12 +20,11 @@
  */
 
 #include "gstomx_adpcmdec.h"
-#include "gstomx_base_filter.h"
 #include "gstomx.h"
 
 #include <string.h> /* for memset */
 
-static GstOmxBaseFilterClass *parent_class;
+static GstOmxBaseAudioDecClass *parent_class;
 
 static GstCaps *
 generate_src_template (void)
@@ -41,7 +40,7 @@ generate_src_template (void)
                                 "channels", G_TYPE_INT, 1,
                                 NULL);
 
-    return caps;
+    return g_omx_convert_pcm_caps (caps);
 }
 
 static GstCaps *
@@ -101,7 +100,7 @@ static void
 type_class_init (gpointer g_class,
                  gpointer class_data)
 {
-    parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+    parent_class = g_type_class_ref (GST_OMX_BASE_AUDIODEC_TYPE);
 }
 
 static gboolean
@@ -169,6 +168,9 @@ type_instance_init (GTypeInstance *instance,
 
     omx_base = GST_OMX_BASE_FILTER (instance);
 
+    /* the src caps follow the sink caps */
+    omx_base->gomx->settings_changed_cb = NULL;
+
     gst_pad_set_setcaps_function (omx_base->sinkpad, sink_setcaps);
 }
 
@@ -188,7 +190,7 @@ gst_omx_adpcmdec_get_type (void)
         type_info->instance_size = sizeof (GstOmxAdpcmDec);
         type_info->instance_init = type_instance_init;
 
-        type = g_type_register_static (GST_OMX_BASE_FILTER_TYPE, "GstOmxAdpcmDec", type_info, 0);
+        type = g_type_register_static (GST_OMX_BASE_AUDIODEC_TYPE, "GstOmxAdpcmDec", type_info, 0);
 
         g_free (type_info);
     }
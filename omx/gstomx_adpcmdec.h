@@ -32,16 +32,16 @@ G_BEGIN_DECLS
 typedef struct GstOmxAdpcmDec GstOmxAdpcmDec;
 typedef struct GstOmxAdpcmDecClass GstOmxAdpcmDecClass;
 
-#include "gstomx_base_filter.h"
+#include "gstomx_base_audiodec.h"
 
 struct GstOmxAdpcmDec
 {
-    GstOmxBaseFilter omx_base;
+    GstOmxBaseAudioDec omx_base;
 };
 
 struct GstOmxAdpcmDecClass
 {
-    GstOmxBaseFilterClass parent_class;
+    GstOmxBaseAudioDecClass parent_class;
 };
 
 GType gst_omx_adpcmdec_get_type (void);
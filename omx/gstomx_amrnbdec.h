@@ -32,16 +32,16 @@ G_BEGIN_DECLS
 typedef struct GstOmxAmrNbDec GstOmxAmrNbDec;
 typedef struct GstOmxAmrNbDecClass GstOmxAmrNbDecClass;
 
-#include "gstomx_base_filter.h"
+#include "gstomx_base_audiodec.h"
 
 struct GstOmxAmrNbDec
 {
-    GstOmxBaseFilter omx_base;
+    GstOmxBaseAudioDec omx_base;
 };
 
 struct GstOmxAmrNbDecClass
 {
-    GstOmxBaseFilterClass parent_class;
+    GstOmxBaseAudioDecClass parent_class;
 };
 
 GType gst_omx_amrnbdec_get_type (void);
@@ -32,17 +32,17 @@ G_BEGIN_DECLS
 typedef struct GstOmxAmrNbEnc GstOmxAmrNbEnc;
 typedef struct GstOmxAmrNbEncClass GstOmxAmrNbEncClass;
 
-#include "gstomx_base_filter.h"
+#include "gstomx_base_audioenc.h"
 
 struct GstOmxAmrNbEnc
 {
-    GstOmxBaseFilter omx_base;
+    GstOmxBaseAudioEnc omx_base;
     guint bitrate;
 };
 
 struct GstOmxAmrNbEncClass
 {
-    GstOmxBaseFilterClass parent_class;
+    GstOmxBaseAudioEncClass parent_class;
 };
 
 GType gst_omx_amrnbenc_get_type (void);
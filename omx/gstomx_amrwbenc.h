@@ -32,17 +32,17 @@ G_BEGIN_DECLS
 typedef struct GstOmxAmrWbEnc GstOmxAmrWbEnc;
 typedef struct GstOmxAmrWbEncClass GstOmxAmrWbEncClass;
 
-#include "gstomx_base_filter.h"
+#include "gstomx_base_audioenc.h"
 
 struct GstOmxAmrWbEnc
 {
-    GstOmxBaseFilter omx_base;
+    GstOmxBaseAudioEnc omx_base;
     guint bitrate;
 };
 
 struct GstOmxAmrWbEncClass
 {
-    GstOmxBaseFilterClass parent_class;
+    GstOmxBaseAudioEncClass parent_class;
 };
 
 GType gst_omx_amrwbenc_get_type (void);
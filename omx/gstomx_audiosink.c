@@ -20,10 +20,21 @@
  */
 
 #include "gstomx_audiosink.h"
+#include "gstomx_clock.h"
 #include "gstomx.h"
 
 #include <string.h> /* for memset */
 
+enum
+{
+    ARG_0,
+    ARG_BUFFER_TIME,
+    ARG_LATENCY_TIME,
+};
+
+#define DEFAULT_BUFFER_TIME 0
+#define DEFAULT_LATENCY_TIME 0
+
 static GstOmxBaseSinkClass *parent_class;
 
 static GstCaps *
@@ -40,7 +51,7 @@ generate_sink_template (void)
                                 "channels", GST_TYPE_INT_RANGE, 1, 8,
                                 NULL);
 
-    return caps;
+    return g_omx_convert_pcm_caps (caps);
 }
 
 static void
@@ -72,15 +83,448 @@ type_base_init (gpointer g_class)
     }
 }
 
+static void
+finalize (GObject *obj)
+{
+    GstOmxAudioSink *self;
+
+    self = GST_OMX_AUDIOSINK (obj);
+
+    gst_object_unref (self->clock);
+    g_queue_free (self->in_flight);
+    g_mutex_free (self->clock_lock);
+
+    G_OBJECT_CLASS (parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject *obj,
+              guint prop_id,
+              const GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxAudioSink *self;
+
+    self = GST_OMX_AUDIOSINK (obj);
+
+    switch (prop_id)
+    {
+        case ARG_BUFFER_TIME:
+            self->buffer_time = g_value_get_int64 (value);
+            break;
+        case ARG_LATENCY_TIME:
+            self->latency_time = g_value_get_int64 (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+get_property (GObject *obj,
+              guint prop_id,
+              GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxAudioSink *self;
+
+    self = GST_OMX_AUDIOSINK (obj);
+
+    switch (prop_id)
+    {
+        case ARG_BUFFER_TIME:
+            g_value_set_int64 (value, self->buffer_time);
+            break;
+        case ARG_LATENCY_TIME:
+            g_value_set_int64 (value, self->latency_time);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+/* Sizes the input buffers from buffer-time and latency-time; the caps
+ * are known by now. */
+static void
+omx_setup (GstOmxBaseSink *omx_base)
+{
+    GstOmxAudioSink *self;
+    GOmxCore *gomx;
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+    GstClockTime latency;
+
+    self = GST_OMX_AUDIOSINK (omx_base);
+    gomx = (GOmxCore *) omx_base->gomx;
+
+    if (self->bytes_per_second == 0 || self->frame_size == 0)
+        return;
+
+    memset (&param, 0, sizeof (param));
+    param.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+    param.nVersion.s.nVersionMajor = 1;
+    param.nVersion.s.nVersionMinor = 1;
+
+    param.nPortIndex = 0;
+    OMX_GetParameter (gomx->omx_handle, OMX_IndexParamPortDefinition, &param);
+
+    if (self->latency_time > 0)
+    {
+        guint size;
+
+        size = gst_util_uint64_scale_int (self->latency_time, self->bytes_per_second, 1000000);
+        size -= size % self->frame_size;
+        param.nBufferSize = MAX (size, self->frame_size);
+    }
+
+    if (self->buffer_time > 0 && param.nBufferSize > 0)
+    {
+        guint64 total;
+        guint count;
+
+        total = gst_util_uint64_scale_int (self->buffer_time, self->bytes_per_second, 1000000);
+        count = (total + param.nBufferSize - 1) / param.nBufferSize;
+        param.nBufferCountActual = MAX (count, MAX (param.nBufferCountMin, 1));
+    }
+
+    if (self->latency_time > 0 || self->buffer_time > 0)
+    {
+        OMX_SetParameter (gomx->omx_handle, OMX_IndexParamPortDefinition, &param);
+        /* see what the component made of it */
+        OMX_GetParameter (gomx->omx_handle, OMX_IndexParamPortDefinition, &param);
+    }
+
+    latency = gst_util_uint64_scale_int ((guint64) param.nBufferCountActual * param.nBufferSize,
+                                         GST_SECOND, self->bytes_per_second);
+
+    GST_INFO_OBJECT (self, "%lu buffers of %lu bytes, latency %" GST_TIME_FORMAT,
+                     param.nBufferCountActual, param.nBufferSize, GST_TIME_ARGS (latency));
+
+    /* buffers go to the component that much before they are due; the base
+     * class reports it as latency, and posts a message when it changes */
+    gst_base_sink_set_render_delay (GST_BASE_SINK (self), latency);
+}
+
+/*
+ * Clock
+ */
+
+static GstClockTime
+system_time (void)
+{
+    GTimeVal now;
+
+    g_get_current_time (&now);
+
+    return GST_TIMEVAL_TO_TIME (now);
+}
+
+static GstClockTime
+duration_of (GstOmxAudioSink *self,
+             guint size)
+{
+    return gst_util_uint64_scale_int (size, GST_SECOND, self->bytes_per_second);
+}
+
+/* From the component's thread. */
+static void
+in_buffer_cb (GOmxPort *port,
+              OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    GstOmxAudioSink *self;
+    guint size;
+
+    self = GST_OMX_AUDIOSINK (port->core->object);
+
+    g_mutex_lock (self->clock_lock);
+
+    if (!g_queue_is_empty (self->in_flight))
+    {
+        size = GPOINTER_TO_UINT (g_queue_pop_head (self->in_flight));
+
+        if (!self->flushing && self->bytes_per_second)
+        {
+            self->played += duration_of (self, size);
+            self->last_update = system_time ();
+
+            if (!g_queue_is_empty (self->in_flight))
+                self->playing = duration_of (self, GPOINTER_TO_UINT (g_queue_peek_head (self->in_flight)));
+            else
+                self->playing = 0;
+        }
+    }
+
+    g_mutex_unlock (self->clock_lock);
+}
+
+static void
+submit_buffer (GstOmxBaseSink *omx_base,
+               OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    GstOmxAudioSink *self;
+
+    self = GST_OMX_AUDIOSINK (omx_base);
+
+    g_mutex_lock (self->clock_lock);
+    if (g_queue_is_empty (self->in_flight) && self->bytes_per_second)
+    {
+        GstClockTime now;
+
+        now = system_time ();
+
+        /* starved until now, with the clock running on; this one starts
+         * right away */
+        if (GST_CLOCK_TIME_IS_VALID (self->last_update) && now > self->last_update)
+            self->played += now - self->last_update;
+
+        self->playing = duration_of (self, omx_buffer->nFilledLen);
+        self->last_update = now;
+    }
+    g_queue_push_tail (self->in_flight, GUINT_TO_POINTER (omx_buffer->nFilledLen));
+    g_mutex_unlock (self->clock_lock);
+}
+
+/* Played so far, interpolated within the buffer being played; while the
+ * component is starved it goes on as if silence was played, so waiting
+ * on it for a later buffer ends. Stopped during a flush. Call with
+ * clock_lock held. */
+static GstClockTime
+clock_time_unlocked (GstOmxAudioSink *self)
+{
+    GstClockTime time;
+
+    time = self->played;
+
+    if (GST_CLOCK_TIME_IS_VALID (self->last_update))
+    {
+        GstClockTime now;
+
+        now = system_time ();
+        if (now > self->last_update)
+        {
+            if (g_queue_is_empty (self->in_flight))
+                time += now - self->last_update;
+            else
+                time += MIN (now - self->last_update, self->playing);
+        }
+    }
+
+    return time;
+}
+
+static GstClockTime
+get_time (GstClock *clock,
+          gpointer user_data)
+{
+    GstOmxAudioSink *self;
+    GstClockTime time;
+
+    self = GST_OMX_AUDIOSINK (user_data);
+
+    g_mutex_lock (self->clock_lock);
+    time = clock_time_unlocked (self);
+    g_mutex_unlock (self->clock_lock);
+
+    return time;
+}
+
+static GstClock *
+provide_clock (GstElement *element)
+{
+    GstOmxAudioSink *self;
+
+    self = GST_OMX_AUDIOSINK (element);
+
+    return GST_CLOCK (gst_object_ref (self->clock));
+}
+
+/* With our own clock the component paces the playback; waiting on top
+ * of that would only add latency. Only the first buffer and those after
+ * a gap wait, to start at the right time. */
+static void
+get_times (GstBaseSink *gst_sink,
+           GstBuffer *buf,
+           GstClockTime *start,
+           GstClockTime *end)
+{
+    GstOmxAudioSink *self;
+
+    self = GST_OMX_AUDIOSINK (gst_sink);
+
+    *start = GST_CLOCK_TIME_NONE;
+    *end = GST_CLOCK_TIME_NONE;
+
+    if (GST_ELEMENT_CLOCK (self) == self->clock &&
+        !self->need_sync && !GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DISCONT))
+        return;
+
+    self->need_sync = FALSE;
+
+    *start = GST_BUFFER_TIMESTAMP (buf);
+    if (GST_CLOCK_TIME_IS_VALID (*start) && GST_BUFFER_DURATION_IS_VALID (buf))
+        *end = *start + GST_BUFFER_DURATION (buf);
+}
+
+/* Buffers coming back from now on weren't played; the clock holds still. */
+static void
+flush_start (GstOmxAudioSink *self)
+{
+    g_mutex_lock (self->clock_lock);
+    self->played = clock_time_unlocked (self);
+    self->last_update = GST_CLOCK_TIME_NONE;
+    self->flushing = TRUE;
+    g_mutex_unlock (self->clock_lock);
+}
+
+/* Nothing in flight any more; the clock runs on from here, and what
+ * comes next waits for its time. */
+static void
+flush_done (GstOmxAudioSink *self)
+{
+    g_mutex_lock (self->clock_lock);
+    while (!g_queue_is_empty (self->in_flight))
+        g_queue_pop_head (self->in_flight);
+    self->playing = 0;
+    self->last_update = system_time ();
+    self->flushing = FALSE;
+    self->need_sync = TRUE;
+    g_mutex_unlock (self->clock_lock);
+}
+
+static gboolean
+handle_event (GstBaseSink *gst_sink,
+              GstEvent *event)
+{
+    GstOmxAudioSink *self;
+    gboolean ret;
+
+    self = GST_OMX_AUDIOSINK (gst_sink);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_START)
+        flush_start (self);
+
+    ret = GST_BASE_SINK_CLASS (parent_class)->event (gst_sink, event);
+
+    /* the base class waited for the flush to complete */
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+        flush_done (self);
+
+    return ret;
+}
+
+static GstStateChangeReturn
+change_state (GstElement *element,
+              GstStateChange transition)
+{
+    GstOmxAudioSink *self;
+    GstStateChangeReturn ret;
+
+    self = GST_OMX_AUDIOSINK (element);
+
+    switch (transition)
+    {
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            flush_done (self);
+            break;
+
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            /* the component hands back what it holds when it stops */
+            flush_start (self);
+            break;
+
+        default:
+            break;
+    }
+
+    ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+    if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+        flush_done (self);
+
+    return ret;
+}
+
+static guint
+in_copy (GstOmxBaseSink *omx_base,
+         OMX_BUFFERHEADERTYPE *omx_buffer,
+         const guint8 *src,
+         guint size)
+{
+    GstOmxAudioSink *self;
+    guint in_frame_size;
+    guint frames;
+
+    self = GST_OMX_AUDIOSINK (omx_base);
+
+    in_frame_size = self->channels * g_omx_convert_pcm_width (&self->in_format);
+
+    frames = MIN (size / in_frame_size,
+                  (omx_buffer->nAllocLen - omx_buffer->nOffset) / self->frame_size);
+
+    g_omx_convert_pcm (src, &self->in_format,
+                       omx_buffer->pBuffer + omx_buffer->nOffset, &self->omx_format,
+                       self->channels, frames, NULL);
+
+    omx_buffer->nFilledLen = frames * self->frame_size;
+
+    /* a partial frame can't be converted */
+    if (frames == 0)
+        return size;
+
+    return frames * in_frame_size;
+}
+
+static gboolean
+set_pcm_params (GstOmxAudioSink *self,
+                gint rate,
+                gint channels,
+                gint width,
+                gboolean is_signed,
+                gboolean is_bigendian,
+                OMX_AUDIO_PARAM_PCMMODETYPE *param)
+{
+    GOmxCore *gomx;
+    OMX_ERRORTYPE error;
+
+    gomx = (GOmxCore *) GST_OMX_BASE_SINK (self)->gomx;
+
+    memset (param, 0, sizeof (*param));
+    param->nSize = sizeof (OMX_AUDIO_PARAM_PCMMODETYPE);
+    param->nVersion.s.nVersionMajor = 1;
+    param->nVersion.s.nVersionMinor = 1;
+
+    param->nPortIndex = 0;
+    OMX_GetParameter (gomx->omx_handle, OMX_IndexParamAudioPcm, param);
+
+    param->nChannels = channels;
+    param->eNumData = is_signed ? OMX_NumericalDataSigned : OMX_NumericalDataUnsigned;
+    param->eEndian = is_bigendian ? OMX_EndianBig : OMX_EndianLittle;
+    param->nBitPerSample = width;
+    param->nSamplingRate = rate;
+
+    error = OMX_SetParameter (gomx->omx_handle, OMX_IndexParamAudioPcm, param);
+
+    /* see what the component made of it */
+    OMX_GetParameter (gomx->omx_handle, OMX_IndexParamAudioPcm, param);
+
+    return error == OMX_ErrorNone &&
+        param->nBitPerSample == (OMX_U32) width &&
+        param->eNumData == (is_signed ? OMX_NumericalDataSigned : OMX_NumericalDataUnsigned) &&
+        param->eEndian == (is_bigendian ? OMX_EndianBig : OMX_EndianLittle);
+}
+
+/* The caps go to the component as they are; what it refuses is
+ * converted to S16 in native order, in the copy into its buffers. */
 static gboolean
 setcaps (GstBaseSink *gst_sink,
          GstCaps *caps)
 {
-    GstOmxBaseSink *self;
-    GOmxCore *gomx;
+    GstOmxBaseSink *omx_base;
+    GstOmxAudioSink *self;
 
-    self = GST_OMX_BASE_SINK (gst_sink);
-    gomx = (GOmxCore *) self->gomx;
+    omx_base = GST_OMX_BASE_SINK (gst_sink);
+    self = GST_OMX_AUDIOSINK (gst_sink);
 
     GST_INFO_OBJECT (self, "setcaps (sink): %" GST_PTR_FORMAT, caps);
 
@@ -88,11 +532,14 @@ setcaps (GstBaseSink *gst_sink,
 
     {
         GstStructure *structure;
-        gint channels;
-        gint width;
-        gint rate;
-        gboolean is_signed;
+        OMX_AUDIO_PARAM_PCMMODETYPE param;
+        gint channels = 0;
+        gint width = 0;
+        gint rate = 0;
+        gboolean is_signed = TRUE;
         gboolean is_bigendian;
+        gboolean is_float;
+        gboolean can_convert;
 
         structure = gst_caps_get_structure (caps, 0);
 
@@ -101,30 +548,42 @@ setcaps (GstBaseSink *gst_sink,
         gst_structure_get_int (structure, "rate", &rate);
         gst_structure_get_boolean (structure, "signed", &is_signed);
         {
-            gint endianness;
+            gint endianness = G_BYTE_ORDER;
             gst_structure_get_int (structure, "endianness", &endianness);
             is_bigendian = (endianness == 1234) ? FALSE : TRUE;
         }
 
-        {
-            OMX_AUDIO_PARAM_PCMMODETYPE param;
-
-            memset (&param, 0, sizeof (param));
-            param.nSize = sizeof (OMX_AUDIO_PARAM_PCMMODETYPE);
-            param.nVersion.s.nVersionMajor = 1;
-            param.nVersion.s.nVersionMinor = 1;
+        is_float = gst_structure_has_name (structure, "audio/x-raw-float");
+        can_convert = g_omx_convert_pcm_from_caps (structure, &self->in_format);
 
-            param.nPortIndex = 0;
-            OMX_GetParameter (gomx->omx_handle, OMX_IndexParamAudioPcm, &param);
+        self->channels = channels;
+        omx_base->in_copy = NULL;
 
-            param.nChannels = channels;
-            param.eNumData = is_signed ? OMX_NumericalDataSigned : OMX_NumericalDataUnsigned;
-            param.eEndian = is_bigendian ? OMX_EndianBig : OMX_EndianLittle;
+        /* OpenMAX has no float samples */
+        if (!is_float &&
+            (set_pcm_params (self, rate, channels, width, is_signed, is_bigendian, &param) || !can_convert))
+        {
+            /* taken, or nothing else to offer; it goes through as it is */
             param.nBitPerSample = width;
-            param.nSamplingRate = rate;
+        }
+        else if (!can_convert ||
+                 !set_pcm_params (self, rate, channels, 16, TRUE, G_BYTE_ORDER == G_BIG_ENDIAN, &param))
+        {
+            GST_WARNING_OBJECT (self, "component refuses the format");
+            return FALSE;
+        }
 
-            OMX_SetParameter (gomx->omx_handle, OMX_IndexParamAudioPcm, &param);
+        /* the component may want planar data, too */
+        if (can_convert && g_omx_convert_pcm_from_omx (&param, &self->omx_format) &&
+            !g_omx_convert_pcm_equal (&self->in_format, &self->omx_format))
+        {
+            GST_INFO_OBJECT (self, "converting to %lu bits%s", param.nBitPerSample,
+                             self->omx_format.planar ? ", planar" : "");
+            omx_base->in_copy = in_copy;
         }
+
+        self->frame_size = channels * (param.nBitPerSample / 8);
+        self->bytes_per_second = rate * self->frame_size;
     }
 
     return TRUE;
@@ -134,12 +593,38 @@ static void
 type_class_init (gpointer g_class,
                  gpointer class_data)
 {
+    GObjectClass *gobject_class;
+    GstElementClass *gstelement_class;
     GstBaseSinkClass *gst_base_sink_class;
 
     parent_class = g_type_class_ref (GST_OMX_BASE_SINK_TYPE);
+    gobject_class = G_OBJECT_CLASS (g_class);
+    gstelement_class = GST_ELEMENT_CLASS (g_class);
     gst_base_sink_class = GST_BASE_SINK_CLASS (g_class);
 
+    gobject_class->finalize = finalize;
+    gstelement_class->provide_clock = provide_clock;
+    gstelement_class->change_state = change_state;
+
     gst_base_sink_class->set_caps = setcaps;
+    gst_base_sink_class->get_times = get_times;
+    gst_base_sink_class->event = handle_event;
+
+    /* Properties stuff */
+    {
+        gobject_class->set_property = set_property;
+        gobject_class->get_property = get_property;
+
+        g_object_class_install_property (gobject_class, ARG_BUFFER_TIME,
+                                         g_param_spec_int64 ("buffer-time", "Buffer time",
+                                                             "Audio queued in the component, in microseconds (0 = component default)",
+                                                             0, G_MAXINT64, DEFAULT_BUFFER_TIME, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_LATENCY_TIME,
+                                         g_param_spec_int64 ("latency-time", "Latency time",
+                                                             "Audio in each buffer, in microseconds (0 = component default)",
+                                                             0, G_MAXINT64, DEFAULT_LATENCY_TIME, G_PARAM_READWRITE));
+    }
 }
 
 static void
@@ -147,10 +632,27 @@ type_instance_init (GTypeInstance *instance,
                     gpointer g_class)
 {
     GstOmxBaseSink *omx_base;
+    GstOmxAudioSink *self;
 
     omx_base = GST_OMX_BASE_SINK (instance);
+    self = GST_OMX_AUDIOSINK (instance);
 
     GST_DEBUG_OBJECT (omx_base, "start");
+
+    omx_base->omx_setup = omx_setup;
+    omx_base->submit_buffer = submit_buffer;
+    omx_base->gomx->in_buffer_cb = in_buffer_cb;
+
+    self->buffer_time = DEFAULT_BUFFER_TIME;
+    self->latency_time = DEFAULT_LATENCY_TIME;
+
+    self->clock_lock = g_mutex_new ();
+    self->in_flight = g_queue_new ();
+    self->last_update = GST_CLOCK_TIME_NONE;
+    self->need_sync = TRUE;
+    self->clock = gst_omx_clock_new ("GstOmxAudioSinkClock", get_time, self);
+
+    GST_OBJECT_FLAG_SET (self, GST_ELEMENT_PROVIDE_CLOCK);
 }
 
 GType
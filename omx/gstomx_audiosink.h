@@ -33,10 +33,31 @@ typedef struct GstOmxAudioSink GstOmxAudioSink;
 typedef struct GstOmxAudioSinkClass GstOmxAudioSinkClass;
 
 #include "gstomx_base_sink.h"
+#include "gstomx_convert.h"
 
 struct GstOmxAudioSink
 {
     GstOmxBaseSink omx_base;
+
+    gint64 buffer_time; /**< In microseconds; 0 keeps the component's */
+    gint64 latency_time; /**< Of one buffer, in microseconds; 0 keeps the component's */
+
+    /* From the caps; the sizes are of what the component takes. */
+    guint bytes_per_second;
+    guint frame_size; /**< Bytes per sample, all channels */
+    guint channels;
+    GOmxPcmFormat in_format;
+    GOmxPcmFormat omx_format; /**< Converted to in the copy if it differs */
+
+    /* The clock counts what the component has consumed. */
+    GstClock *clock;
+    GMutex *clock_lock;
+    GQueue *in_flight; /**< Sizes of the buffers the component holds, oldest first */
+    gboolean flushing; /**< Buffers coming back now weren't played */
+    GstClockTime played;
+    GstClockTime playing; /**< Duration of the buffer after those */
+    GstClockTime last_update; /**< System time of the last buffer done */
+    gboolean need_sync; /**< Next buffer waits for its time, even on our clock */
 };
 
 struct GstOmxAudioSinkClass
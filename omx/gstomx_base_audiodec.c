@@ -0,0 +1,480 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gstomx_base_audiodec.h"
+#include "gstomx.h"
+
+#include <string.h> /* for memset, memcpy */
+
+/* Component timestamps further than this from the sample count are
+ * taken as a discontinuity. */
+#define RESYNC_THRESHOLD (GST_SECOND / 20)
+
+static GstOmxBaseFilterClass *parent_class;
+
+static void
+type_class_init (gpointer g_class,
+                 gpointer class_data)
+{
+    parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+}
+
+/* The component's own format if downstream takes it, or else whatever
+ * downstream prefers that we can convert to. */
+static GstCaps *
+negotiate_caps (GstOmxBaseAudioDec *self,
+                gint rate,
+                gint channels)
+{
+    GstOmxBaseFilter *omx_base;
+    GOmxPcmFormat format;
+    GstCaps *caps;
+    GstCaps *allowed;
+
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    format = self->omx_format;
+    format.planar = FALSE;
+
+    caps = g_omx_convert_pcm_to_caps (&format, rate, channels);
+    g_omx_convert_channels_to_caps (gst_caps_get_structure (caps, 0), channels,
+                                    self->omx_channels);
+
+    if (gst_pad_peer_accept_caps (omx_base->srcpad, caps))
+        return caps;
+
+    allowed = gst_pad_get_allowed_caps (omx_base->srcpad);
+    if (allowed)
+    {
+        GstCaps *convertible;
+        GstCaps *tmp;
+
+        convertible = g_omx_convert_pcm_caps (gst_caps_ref (caps));
+        tmp = gst_caps_intersect (allowed, convertible);
+        gst_caps_unref (convertible);
+        gst_caps_unref (allowed);
+
+        if (!gst_caps_is_empty (tmp))
+        {
+            gst_caps_truncate (tmp);
+            gst_pad_fixate_caps (omx_base->srcpad, tmp);
+
+            GST_INFO_OBJECT (self, "downstream refuses the component's format, converting");
+            gst_caps_unref (caps);
+            return tmp;
+        }
+
+        gst_caps_unref (tmp);
+    }
+
+    return caps;
+}
+
+static void
+settings_changed_cb (GOmxCore *core)
+{
+    GstOmxBaseFilter *omx_base;
+    GstOmxBaseAudioDec *self;
+    guint rate;
+    guint channels;
+
+    omx_base = core->object;
+    self = GST_OMX_BASE_AUDIODEC (omx_base);
+
+    GST_DEBUG_OBJECT (omx_base, "settings changed");
+
+    {
+        OMX_AUDIO_PARAM_PCMMODETYPE param;
+
+        memset (&param, 0, sizeof (param));
+        param.nSize = sizeof (OMX_AUDIO_PARAM_PCMMODETYPE);
+        param.nVersion.s.nVersionMajor = 1;
+        param.nVersion.s.nVersionMinor = 1;
+
+        param.nPortIndex = 1;
+        OMX_GetParameter (omx_base->gomx->omx_handle, OMX_IndexParamAudioPcm, &param);
+
+        rate = param.nSamplingRate;
+        channels = param.nChannels;
+        if (rate == 0)
+        {
+            /** @todo: this shouldn't happen. */
+            GST_WARNING_OBJECT (omx_base, "Bad samplerate");
+            rate = 44100;
+        }
+
+        if (!g_omx_convert_pcm_from_omx (&param, &self->omx_format))
+        {
+            GST_WARNING_OBJECT (omx_base, "Unknown sample format, assuming S16");
+            self->omx_format.type = GOMX_PCM_S16;
+            self->omx_format.endianness = G_BYTE_ORDER;
+            self->omx_format.planar = FALSE;
+        }
+
+        /* many components leave it empty */
+        memcpy (self->omx_channels, param.eChannelMapping, sizeof (self->omx_channels));
+        if (self->omx_channels[0] == OMX_AUDIO_ChannelNone)
+            g_omx_convert_channels_default (channels, self->omx_channels);
+    }
+
+    {
+        GstCaps *new_caps;
+
+        new_caps = negotiate_caps (self, rate, channels);
+
+        GST_INFO_OBJECT (omx_base, "caps are: %" GST_PTR_FORMAT, new_caps);
+        gst_pad_set_caps (omx_base->srcpad, new_caps);
+        gst_caps_unref (new_caps);
+    }
+}
+
+static guint
+out_size (GstOmxBaseFilter *omx_base,
+          OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    GstOmxBaseAudioDec *self;
+    guint frames;
+
+    self = GST_OMX_BASE_AUDIODEC (omx_base);
+
+    frames = omx_buffer->nFilledLen / (self->channels * g_omx_convert_pcm_width (&self->omx_format));
+
+    return frames * self->sample_size;
+}
+
+static void
+out_copy (GstOmxBaseFilter *omx_base,
+          guint8 *dest,
+          OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    GstOmxBaseAudioDec *self;
+    guint frames;
+
+    self = GST_OMX_BASE_AUDIODEC (omx_base);
+
+    frames = omx_buffer->nFilledLen / (self->channels * g_omx_convert_pcm_width (&self->omx_format));
+
+    g_omx_convert_pcm (omx_buffer->pBuffer + omx_buffer->nOffset, &self->omx_format,
+                       dest, &self->out_format,
+                       self->channels, frames,
+                       self->reorder ? self->channel_map : NULL);
+}
+
+/* Subclasses may set the src caps themselves; this sees them all, and
+ * converts in the copy out of OpenMAX when they differ from the
+ * component's format or channel order. */
+static gboolean
+src_setcaps (GstPad *pad,
+             GstCaps *caps)
+{
+    GstOmxBaseFilter *omx_base;
+    GstOmxBaseAudioDec *self;
+    GstStructure *structure;
+    GOmxPcmFormat format;
+    gint rate = 0;
+    gint channels = 0;
+    gint width = 0;
+
+    omx_base = GST_OMX_BASE_FILTER (GST_PAD_PARENT (pad));
+    self = GST_OMX_BASE_AUDIODEC (omx_base);
+
+    structure = gst_caps_get_structure (caps, 0);
+
+    gst_structure_get_int (structure, "rate", &rate);
+    gst_structure_get_int (structure, "channels", &channels);
+    gst_structure_get_int (structure, "width", &width);
+
+    if (!g_omx_convert_pcm_from_caps (structure, &format))
+        return FALSE;
+
+    self->rate = rate;
+    self->channels = channels;
+    self->sample_size = channels * width / 8;
+    self->out_format = format;
+
+    self->reorder = FALSE;
+    if (channels > 2 && channels <= OMX_AUDIO_MAXCHANNELS)
+    {
+        OMX_AUDIO_CHANNELTYPE out_channels[OMX_AUDIO_MAXCHANNELS];
+
+        if (self->omx_channels[0] == OMX_AUDIO_ChannelNone)
+            g_omx_convert_channels_default (channels, self->omx_channels);
+
+        g_omx_convert_channels_from_caps (structure, channels, out_channels);
+        self->reorder = g_omx_convert_channel_map (self->omx_channels, out_channels,
+                                                   channels, self->channel_map);
+        if (self->reorder)
+            GST_INFO_OBJECT (self, "reordering channels");
+    }
+
+    if (channels > 0 && (self->reorder || !g_omx_convert_pcm_equal (&format, &self->omx_format)))
+    {
+        omx_base->out_size = out_size;
+        omx_base->out_copy = out_copy;
+    }
+    else
+    {
+        omx_base->out_size = NULL;
+        omx_base->out_copy = NULL;
+    }
+
+    return TRUE;
+}
+
+static void
+timing_reset (GstOmxBaseAudioDec *self)
+{
+    self->base_timestamp = GST_CLOCK_TIME_NONE;
+    self->sample_count = 0;
+    self->offset = 0;
+}
+
+/* Drops what's outside the segment; FALSE if nothing is left. */
+static gboolean
+clip_buffer (GstOmxBaseAudioDec *self,
+             GstBuffer **buf,
+             guint64 samples)
+{
+    GstClockTime start;
+    GstClockTime stop;
+    gint64 clip_start;
+    gint64 clip_stop;
+    guint64 head;
+    guint64 tail;
+    gboolean in_segment;
+
+    start = GST_BUFFER_TIMESTAMP (*buf);
+    stop = start + GST_BUFFER_DURATION (*buf);
+
+    GST_OBJECT_LOCK (self);
+    if (self->segment.format != GST_FORMAT_TIME)
+    {
+        GST_OBJECT_UNLOCK (self);
+        return TRUE;
+    }
+    in_segment = gst_segment_clip (&self->segment, GST_FORMAT_TIME, start, stop,
+                                   &clip_start, &clip_stop);
+    GST_OBJECT_UNLOCK (self);
+
+    if (!in_segment)
+        return FALSE;
+
+    if ((GstClockTime) clip_start == start && (GstClockTime) clip_stop == stop)
+        return TRUE;
+
+    head = gst_util_uint64_scale_int (clip_start - start, self->rate, GST_SECOND);
+    tail = gst_util_uint64_scale_int (stop - clip_stop, self->rate, GST_SECOND);
+
+    if (head + tail >= samples)
+        return FALSE;
+
+    GST_LOG_OBJECT (self, "clipping %" G_GUINT64_FORMAT " + %" G_GUINT64_FORMAT " samples",
+                    head, tail);
+
+    {
+        GstBuffer *sub;
+
+        sub = gst_buffer_create_sub (*buf, head * self->sample_size,
+                                     (samples - head - tail) * self->sample_size);
+        gst_buffer_set_caps (sub, GST_BUFFER_CAPS (*buf));
+
+        GST_BUFFER_TIMESTAMP (sub) = start +
+            gst_util_uint64_scale_int (head, GST_SECOND, self->rate);
+        GST_BUFFER_DURATION (sub) = stop - GST_BUFFER_TIMESTAMP (sub) -
+            gst_util_uint64_scale_int (tail, GST_SECOND, self->rate);
+        GST_BUFFER_OFFSET (sub) = GST_BUFFER_OFFSET (*buf) + head;
+        GST_BUFFER_OFFSET_END (sub) = GST_BUFFER_OFFSET_END (*buf) - tail;
+        if (GST_BUFFER_FLAG_IS_SET (*buf, GST_BUFFER_FLAG_DISCONT))
+            GST_BUFFER_FLAG_SET (sub, GST_BUFFER_FLAG_DISCONT);
+
+        gst_buffer_unref (*buf);
+        *buf = sub;
+    }
+
+    return TRUE;
+}
+
+static GstFlowReturn
+push_output (GstOmxBaseFilter *omx_base,
+             GstBuffer *buf,
+             OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    GstOmxBaseAudioDec *self;
+    GstClockTime timestamp;
+    guint64 samples;
+
+    self = GST_OMX_BASE_AUDIODEC (omx_base);
+
+    /* not negotiated yet */
+    if (self->rate <= 0 || self->sample_size == 0)
+        return gst_pad_push (omx_base->srcpad, buf);
+
+    samples = GST_BUFFER_SIZE (buf) / self->sample_size;
+    timestamp = GST_BUFFER_TIMESTAMP (buf);
+
+    if (!GST_CLOCK_TIME_IS_VALID (self->base_timestamp))
+    {
+        if (!GST_CLOCK_TIME_IS_VALID (timestamp))
+        {
+            GST_OBJECT_LOCK (self);
+            if (self->segment.format == GST_FORMAT_TIME && self->segment.start >= 0)
+                timestamp = self->segment.start;
+            else
+                timestamp = 0;
+            GST_OBJECT_UNLOCK (self);
+        }
+
+        self->base_timestamp = timestamp;
+        self->sample_count = 0;
+    }
+    else if (GST_CLOCK_TIME_IS_VALID (timestamp))
+    {
+        GstClockTime expected;
+        GstClockTimeDiff diff;
+
+        expected = self->base_timestamp +
+            gst_util_uint64_scale_int (self->sample_count, GST_SECOND, self->rate);
+        diff = GST_CLOCK_DIFF (expected, timestamp);
+
+        if (ABS (diff) > RESYNC_THRESHOLD)
+        {
+            GST_DEBUG_OBJECT (self, "resync: expected %" GST_TIME_FORMAT ", got %" GST_TIME_FORMAT,
+                              GST_TIME_ARGS (expected), GST_TIME_ARGS (timestamp));
+            self->base_timestamp = timestamp;
+            self->sample_count = 0;
+            GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+        }
+    }
+
+    /* from the sample count, so rounding doesn't accumulate */
+    timestamp = self->base_timestamp +
+        gst_util_uint64_scale_int (self->sample_count, GST_SECOND, self->rate);
+    GST_BUFFER_TIMESTAMP (buf) = timestamp;
+    GST_BUFFER_DURATION (buf) = self->base_timestamp +
+        gst_util_uint64_scale_int (self->sample_count + samples, GST_SECOND, self->rate) -
+        timestamp;
+    GST_BUFFER_OFFSET (buf) = self->offset;
+    GST_BUFFER_OFFSET_END (buf) = self->offset + samples;
+
+    self->sample_count += samples;
+    self->offset += samples;
+
+    if (!clip_buffer (self, &buf, samples))
+    {
+        GST_LOG_OBJECT (self, "outside of the segment: %" GST_TIME_FORMAT,
+                        GST_TIME_ARGS (timestamp));
+        gst_buffer_unref (buf);
+        return GST_FLOW_OK;
+    }
+
+    return gst_pad_push (omx_base->srcpad, buf);
+}
+
+static gboolean
+sink_event (GstPad *pad,
+            GstEvent *event)
+{
+    GstOmxBaseAudioDec *self;
+
+    self = GST_OMX_BASE_AUDIODEC (GST_OBJECT_PARENT (pad));
+
+    switch (GST_EVENT_TYPE (event))
+    {
+        case GST_EVENT_FLUSH_STOP:
+            /* the output task is stopped until the base class restarts it */
+            timing_reset (self);
+            GST_OBJECT_LOCK (self);
+            gst_segment_init (&self->segment, GST_FORMAT_TIME);
+            GST_OBJECT_UNLOCK (self);
+            break;
+        case GST_EVENT_NEWSEGMENT:
+            {
+                gboolean update;
+                gdouble rate;
+                GstFormat format;
+                gint64 start;
+                gint64 stop;
+                gint64 position;
+
+                gst_event_parse_new_segment (event, &update, &rate, &format,
+                                             &start, &stop, &position);
+
+                GST_OBJECT_LOCK (self);
+                gst_segment_set_newsegment (&self->segment, update, rate, format,
+                                            start, stop, position);
+                GST_OBJECT_UNLOCK (self);
+                break;
+            }
+        default:
+            break;
+    }
+
+    return self->base_sink_event (pad, event);
+}
+
+static void
+type_instance_init (GTypeInstance *instance,
+                    gpointer g_class)
+{
+    GstOmxBaseFilter *omx_base;
+    GstOmxBaseAudioDec *self;
+
+    omx_base = GST_OMX_BASE_FILTER (instance);
+    self = GST_OMX_BASE_AUDIODEC (instance);
+
+    omx_base->push_output = push_output;
+
+    omx_base->gomx->settings_changed_cb = settings_changed_cb;
+
+    gst_pad_set_setcaps_function (omx_base->srcpad, src_setcaps);
+
+    self->base_sink_event = GST_PAD_EVENTFUNC (omx_base->sinkpad);
+    gst_pad_set_event_function (omx_base->sinkpad, sink_event);
+
+    /* what components have always been taken to output */
+    self->omx_format.type = GOMX_PCM_S16;
+    self->omx_format.endianness = G_BYTE_ORDER;
+    self->omx_format.planar = FALSE;
+
+    gst_segment_init (&self->segment, GST_FORMAT_TIME);
+    timing_reset (self);
+}
+
+GType
+gst_omx_base_audiodec_get_type (void)
+{
+    static GType type = 0;
+
+    if (G_UNLIKELY (type == 0))
+    {
+        GTypeInfo *type_info;
+
+        type_info = g_new0 (GTypeInfo, 1);
+        type_info->class_size = sizeof (GstOmxBaseAudioDecClass);
+        type_info->class_init = type_class_init;
+        type_info->instance_size = sizeof (GstOmxBaseAudioDec);
+        type_info->instance_init = type_instance_init;
+
+        type = g_type_register_static (GST_OMX_BASE_FILTER_TYPE, "GstOmxBaseAudioDec", type_info, 0);
+
+        g_free (type_info);
+    }
+
+    return type;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef GSTOMX_BASE_AUDIODEC_H
+#define GSTOMX_BASE_AUDIODEC_H
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_OMX_BASE_AUDIODEC(obj) (GstOmxBaseAudioDec *) (obj)
+#define GST_OMX_BASE_AUDIODEC_TYPE (gst_omx_base_audiodec_get_type ())
+#define GST_OMX_BASE_AUDIODEC_CLASS(c) (G_TYPE_CHECK_CLASS_CAST ((c), GST_OMX_BASE_AUDIODEC_TYPE, GstOmxBaseAudioDecClass))
+
+typedef struct GstOmxBaseAudioDec GstOmxBaseAudioDec;
+typedef struct GstOmxBaseAudioDecClass GstOmxBaseAudioDecClass;
+
+#include "gstomx_base_filter.h"
+#include "gstomx_convert.h"
+
+struct GstOmxBaseAudioDec
+{
+    GstOmxBaseFilter omx_base;
+
+    /* From the src caps. */
+    gint rate;
+    guint channels;
+    guint sample_size; /**< Bytes per sample, all channels */
+    GOmxPcmFormat out_format;
+
+    GOmxPcmFormat omx_format; /**< What the component outputs; converted if it differs */
+    OMX_AUDIO_CHANNELTYPE omx_channels[OMX_AUDIO_MAXCHANNELS]; /**< Its channel order; reordered if it differs */
+    guint channel_map[OMX_AUDIO_MAXCHANNELS];
+    gboolean reorder; /**< The channel map is in use */
+
+    /* Output timing; samples are counted from the last resync. */
+    GstClockTime base_timestamp;
+    guint64 sample_count;
+    guint64 offset; /**< Samples pushed since the last flush */
+    GstSegment segment;
+    GstPadEventFunction base_sink_event;
+};
+
+struct GstOmxBaseAudioDecClass
+{
+    GstOmxBaseFilterClass parent_class;
+};
+
+GType gst_omx_base_audiodec_get_type (void);
+
+G_END_DECLS
+
+#endif /* GSTOMX_BASE_AUDIODEC_H */
@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gstomx_base_audioenc.h"
+#include "gstomx.h"
+
+#include <string.h> /* for memset, memcpy */
+
+enum
+{
+    ARG_0,
+    ARG_FRAMES_PER_BUFFER,
+};
+
+#define DEFAULT_FRAMES_PER_BUFFER 1
+
+/* Upstream timestamps further than this from the sample count win. */
+#define DRIFT_TOLERANCE (40 * GST_MSECOND)
+
+static GstOmxBaseFilterClass *parent_class;
+
+static void
+finalize (GObject *obj)
+{
+    GstOmxBaseAudioEnc *self;
+
+    self = GST_OMX_BASE_AUDIOENC (obj);
+
+    g_object_unref (self->adapter);
+    gst_caps_replace (&self->frame_caps, NULL);
+
+    G_OBJECT_CLASS (parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject *obj,
+              guint prop_id,
+              const GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxBaseAudioEnc *self;
+
+    self = GST_OMX_BASE_AUDIOENC (obj);
+
+    switch (prop_id)
+    {
+        case ARG_FRAMES_PER_BUFFER:
+            self->frames_per_buffer = g_value_get_uint (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+get_property (GObject *obj,
+              guint prop_id,
+              GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxBaseAudioEnc *self;
+
+    self = GST_OMX_BASE_AUDIOENC (obj);
+
+    switch (prop_id)
+    {
+        case ARG_FRAMES_PER_BUFFER:
+            g_value_set_uint (value, self->frames_per_buffer);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+type_class_init (gpointer g_class,
+                 gpointer class_data)
+{
+    GObjectClass *gobject_class;
+
+    gobject_class = G_OBJECT_CLASS (g_class);
+
+    parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+
+    gobject_class->finalize = finalize;
+
+    /* Properties stuff */
+    {
+        gobject_class->set_property = set_property;
+        gobject_class->get_property = get_property;
+
+        g_object_class_install_property (gobject_class, ARG_FRAMES_PER_BUFFER,
+                                         g_param_spec_uint ("frames-per-buffer", "Frames per buffer",
+                                                            "Codec frames in each OpenMAX buffer; more is cheaper, fewer has less latency. "
+                                                            "Changes apply when the component is started again",
+                                                            1, 100, DEFAULT_FRAMES_PER_BUFFER, G_PARAM_READWRITE));
+    }
+}
+
+/* FALSE when the input isn't packed. */
+static gboolean
+update_frame_size (GstOmxBaseAudioEnc *self,
+                   GstCaps *caps)
+{
+    if (self->frame_duration == 0 || !caps)
+        return FALSE;
+
+    if (caps != self->frame_caps)
+    {
+        GstStructure *structure;
+        gint rate = 0;
+        gint channels = 0;
+        gint width = 0;
+        guint samples;
+
+        structure = gst_caps_get_structure (caps, 0);
+
+        gst_structure_get_int (structure, "rate", &rate);
+        gst_structure_get_int (structure, "channels", &channels);
+        gst_structure_get_int (structure, "width", &width);
+
+        samples = gst_util_uint64_scale_int (self->frame_duration, rate, GST_SECOND);
+
+        self->frame_size = samples * channels * (width / 8);
+        self->bytes_per_second = rate * channels * (width / 8);
+        gst_caps_replace (&self->frame_caps, caps);
+
+        GST_INFO_OBJECT (self, "codec frame: %u bytes", self->frame_size);
+    }
+
+    return self->frame_size > 0;
+}
+
+/* Make room for a whole packet in each buffer, before they are allocated. */
+static void
+setup_input_port (GstOmxBaseAudioEnc *self,
+                  guint size)
+{
+    GOmxCore *gomx;
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+
+    gomx = GST_OMX_BASE_FILTER (self)->gomx;
+
+    memset (&param, 0, sizeof (param));
+    param.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+    param.nVersion.s.nVersionMajor = 1;
+    param.nVersion.s.nVersionMinor = 1;
+
+    param.nPortIndex = 0;
+    OMX_GetParameter (gomx->omx_handle, OMX_IndexParamPortDefinition, &param);
+
+    if (param.nBufferSize < size)
+    {
+        param.nBufferSize = size;
+        OMX_SetParameter (gomx->omx_handle, OMX_IndexParamPortDefinition, &param);
+    }
+}
+
+static GstFlowReturn
+push_packet (GstOmxBaseAudioEnc *self,
+             GstPad *pad,
+             GstBuffer *buf)
+{
+    GST_BUFFER_TIMESTAMP (buf) = self->timestamp;
+    GST_BUFFER_DURATION (buf) = gst_util_uint64_scale_int (GST_BUFFER_SIZE (buf), GST_SECOND,
+                                                           self->bytes_per_second);
+
+    if (GST_CLOCK_TIME_IS_VALID (self->timestamp))
+        self->timestamp += GST_BUFFER_DURATION (buf);
+
+    GST_LOG_OBJECT (self, "packet: size=%u, timestamp=%" GST_TIME_FORMAT,
+                    GST_BUFFER_SIZE (buf), GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
+
+    return self->base_chain (pad, buf);
+}
+
+/* What's left, padded with silence to whole codec frames. */
+static GstFlowReturn
+flush_remainder (GstOmxBaseAudioEnc *self,
+                 GstPad *pad)
+{
+    GstBuffer *buf;
+    guint avail;
+    guint size;
+
+    avail = gst_adapter_available (self->adapter);
+    if (avail == 0 || self->frame_size == 0)
+        return GST_FLOW_OK;
+
+    size = ((avail + self->frame_size - 1) / self->frame_size) * self->frame_size;
+
+    buf = gst_buffer_new_and_alloc (size);
+    memcpy (GST_BUFFER_DATA (buf), gst_adapter_peek (self->adapter, avail), avail);
+    memset (GST_BUFFER_DATA (buf) + avail, 0, size - avail);
+    gst_adapter_clear (self->adapter);
+
+    return push_packet (self, pad, buf);
+}
+
+static GstFlowReturn
+pad_chain (GstPad *pad,
+           GstBuffer *buf)
+{
+    GstOmxBaseAudioEnc *self;
+    GstFlowReturn ret = GST_FLOW_OK;
+    guint size;
+
+    self = GST_OMX_BASE_AUDIOENC (GST_OBJECT_PARENT (pad));
+
+    if (!update_frame_size (self, GST_PAD_CAPS (pad)))
+        return self->base_chain (pad, buf);
+
+    /* the port buffers are sized for this many, until the next start */
+    if (GST_OMX_BASE_FILTER (self)->gomx->omx_state == OMX_StateLoaded)
+    {
+        self->packet_frames = self->frames_per_buffer;
+        setup_input_port (self, self->frame_size * self->packet_frames);
+    }
+
+    size = self->frame_size * self->packet_frames;
+
+    /* timestamps of later buffers are implied by the sample count, as long
+     * as upstream doesn't jump or drift away from it */
+    if (GST_BUFFER_TIMESTAMP_IS_VALID (buf))
+    {
+        GstClockTime pending;
+        GstClockTime timestamp;
+        guint avail;
+
+        timestamp = GST_BUFFER_TIMESTAMP (buf);
+        avail = gst_adapter_available (self->adapter);
+        pending = gst_util_uint64_scale_int (avail, GST_SECOND, self->bytes_per_second);
+
+        if (avail == 0)
+        {
+            self->timestamp = timestamp;
+        }
+        else if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DISCONT) ||
+                 !GST_CLOCK_TIME_IS_VALID (self->timestamp) ||
+                 timestamp < pending)
+        {
+            /* what's pending belongs before the gap */
+            GST_DEBUG_OBJECT (self, "discontinuity at %" GST_TIME_FORMAT,
+                              GST_TIME_ARGS (timestamp));
+            ret = flush_remainder (self, pad);
+            self->timestamp = timestamp;
+        }
+        else if (timestamp > self->timestamp + pending + DRIFT_TOLERANCE ||
+                 timestamp + DRIFT_TOLERANCE < self->timestamp + pending)
+        {
+            GST_DEBUG_OBJECT (self, "resync: expected %" GST_TIME_FORMAT ", got %" GST_TIME_FORMAT,
+                              GST_TIME_ARGS (self->timestamp + pending),
+                              GST_TIME_ARGS (timestamp));
+            self->timestamp = timestamp - pending;
+        }
+    }
+
+    gst_adapter_push (self->adapter, buf);
+
+    while (ret == GST_FLOW_OK && gst_adapter_available (self->adapter) >= size)
+        ret = push_packet (self, pad, gst_adapter_take_buffer (self->adapter, size));
+
+    return ret;
+}
+
+static gboolean
+sink_event (GstPad *pad,
+            GstEvent *event)
+{
+    GstOmxBaseAudioEnc *self;
+
+    self = GST_OMX_BASE_AUDIOENC (GST_OBJECT_PARENT (pad));
+
+    switch (GST_EVENT_TYPE (event))
+    {
+        case GST_EVENT_EOS:
+            flush_remainder (self, pad);
+            break;
+        case GST_EVENT_FLUSH_STOP:
+            gst_adapter_clear (self->adapter);
+            self->timestamp = GST_CLOCK_TIME_NONE;
+            break;
+        default:
+            break;
+    }
+
+    return self->base_sink_event (pad, event);
+}
+
+static void
+type_instance_init (GTypeInstance *instance,
+                    gpointer g_class)
+{
+    GstOmxBaseFilter *omx_base;
+    GstOmxBaseAudioEnc *self;
+
+    omx_base = GST_OMX_BASE_FILTER (instance);
+    self = GST_OMX_BASE_AUDIOENC (instance);
+
+    self->base_chain = GST_PAD_CHAINFUNC (omx_base->sinkpad);
+    gst_pad_set_chain_function (omx_base->sinkpad, pad_chain);
+
+    self->base_sink_event = GST_PAD_EVENTFUNC (omx_base->sinkpad);
+    gst_pad_set_event_function (omx_base->sinkpad, sink_event);
+
+    self->frames_per_buffer = DEFAULT_FRAMES_PER_BUFFER;
+    self->packet_frames = DEFAULT_FRAMES_PER_BUFFER;
+    self->timestamp = GST_CLOCK_TIME_NONE;
+    self->adapter = gst_adapter_new ();
+}
+
+GType
+gst_omx_base_audioenc_get_type (void)
+{
+    static GType type = 0;
+
+    if (G_UNLIKELY (type == 0))
+    {
+        GTypeInfo *type_info;
+
+        type_info = g_new0 (GTypeInfo, 1);
+        type_info->class_size = sizeof (GstOmxBaseAudioEncClass);
+        type_info->class_init = type_class_init;
+        type_info->instance_size = sizeof (GstOmxBaseAudioEnc);
+        type_info->instance_init = type_instance_init;
+
+        type = g_type_register_static (GST_OMX_BASE_FILTER_TYPE, "GstOmxBaseAudioEnc", type_info, 0);
+
+        g_free (type_info);
+    }
+
+    return type;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef GSTOMX_BASE_AUDIOENC_H
+#define GSTOMX_BASE_AUDIOENC_H
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_OMX_BASE_AUDIOENC(obj) (GstOmxBaseAudioEnc *) (obj)
+#define GST_OMX_BASE_AUDIOENC_TYPE (gst_omx_base_audioenc_get_type ())
+#define GST_OMX_BASE_AUDIOENC_CLASS(c) (G_TYPE_CHECK_CLASS_CAST ((c), GST_OMX_BASE_AUDIOENC_TYPE, GstOmxBaseAudioEncClass))
+
+typedef struct GstOmxBaseAudioEnc GstOmxBaseAudioEnc;
+typedef struct GstOmxBaseAudioEncClass GstOmxBaseAudioEncClass;
+
+#include "gstomx_base_filter.h"
+#include <gst/base/gstadapter.h>
+
+struct GstOmxBaseAudioEnc
+{
+    GstOmxBaseFilter omx_base;
+
+    /* Input packing, whole codec frames per OpenMAX buffer. */
+    GstClockTime frame_duration; /**< Of one codec frame; 0 disables packing */
+    guint frames_per_buffer;
+    guint packet_frames; /**< frames_per_buffer when the port was set up */
+    GstAdapter *adapter;
+    GstClockTime timestamp; /**< Of the first sample in the adapter */
+    GstCaps *frame_caps; /**< Sink caps the sizes below come from */
+    guint frame_size; /**< Bytes of PCM per codec frame */
+    guint bytes_per_second;
+    GstPadChainFunction base_chain;
+    GstPadEventFunction base_sink_event;
+};
+
+struct GstOmxBaseAudioEncClass
+{
+    GstOmxBaseFilterClass parent_class;
+};
+
+GType gst_omx_base_audioenc_get_type (void);
+
+G_END_DECLS
+
+#endif /* GSTOMX_BASE_AUDIOENC_H */
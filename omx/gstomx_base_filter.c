@@ -43,6 +43,9 @@ setup_ports (GstOmxBaseFilter *self)
 
     core = self->gomx;
 
+    self->out_sync_flags = FALSE;
+    g_atomic_int_set (&self->input_eos, FALSE);
+
     memset (&param, 0, sizeof (param));
     param.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
     param.nVersion.s.nVersionMajor = 1;
@@ -273,13 +276,33 @@ type_class_init (gpointer g_class,
 
 static inline GstFlowReturn
 push_buffer (GstOmxBaseFilter *self,
-             GstBuffer *buf)
+             GstBuffer *buf,
+             OMX_BUFFERHEADERTYPE *omx_buffer)
 {
     GstFlowReturn ret;
 
+    /* Not every component sets the flag; until one is seen, all
+     * buffers are left as keyframes. */
+    if (omx_buffer->nFlags & OMX_BUFFERFLAG_SYNCFRAME)
+        self->out_sync_flags = TRUE;
+
+    if (self->out_sync_flags)
+    {
+        if (omx_buffer->nFlags & OMX_BUFFERFLAG_SYNCFRAME)
+            GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+        else
+            GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+    }
+
+    if (self->prepare_output)
+        self->prepare_output (self, buf, omx_buffer);
+
     /** @todo check if tainted */
     GST_LOG_OBJECT (self, "begin");
-    ret = gst_pad_push (self->srcpad, buf);
+    if (self->push_output)
+        ret = self->push_output (self, buf, omx_buffer);
+    else
+        ret = gst_pad_push (self->srcpad, buf);
     GST_LOG_OBJECT (self, "end");
 
     return ret;
@@ -328,7 +351,13 @@ output_loop (gpointer data)
                           omx_buffer->nAllocLen, omx_buffer->nFilledLen, omx_buffer->nFlags,
                           omx_buffer->nOffset, omx_buffer->nTimeStamp);
 
-        if (G_LIKELY (omx_buffer->nFilledLen > 0))
+        if (G_UNLIKELY (omx_buffer->nFlags & OMX_BUFFERFLAG_DECODEONLY) &&
+            !(omx_buffer->nFlags & OMX_BUFFERFLAG_EOS))
+        {
+            /* nobody will see it; don't copy it */
+            GST_LOG_OBJECT (self, "decode only: dropping");
+        }
+        else if (G_LIKELY (omx_buffer->nFilledLen > 0))
         {
             GstBuffer *buf;
 
@@ -380,7 +409,7 @@ output_loop (gpointer data)
 
                 gst_pad_set_caps (self->srcpad, caps);
             }
-            else if (buf && !(omx_buffer->nFlags & OMX_BUFFERFLAG_EOS))
+            else if (buf && !self->out_copy && !(omx_buffer->nFlags & OMX_BUFFERFLAG_EOS))
             {
                 GST_BUFFER_SIZE (buf) = omx_buffer->nFilledLen;
                 if (self->use_timestamps)
@@ -393,7 +422,7 @@ output_loop (gpointer data)
                 omx_buffer->pAppPrivate = NULL;
                 omx_buffer->pBuffer = NULL;
 
-                ret = push_buffer (self, buf);
+                ret = push_buffer (self, buf, omx_buffer);
 
                 gst_buffer_unref (buf);
             }
@@ -402,15 +431,34 @@ output_loop (gpointer data)
                 /* This is only meant for the first OpenMAX buffers,
                  * which need to be pre-allocated. */
                 /* Also for the very last one. */
-                ret = gst_pad_alloc_buffer_and_set_caps (self->srcpad,
-                                                         GST_BUFFER_OFFSET_NONE,
-                                                         omx_buffer->nFilledLen,
-                                                         GST_PAD_CAPS (self->srcpad),
-                                                         &buf);
+                /* And whenever the data needs converting on the way out. */
+                guint size;
+
+                size = omx_buffer->nFilledLen;
+                if (self->out_size)
+                    size = self->out_size (self, omx_buffer);
+
+                if (G_UNLIKELY (size == 0))
+                {
+                    /* out_size found nothing usable in it */
+                    GST_WARNING_OBJECT (self, "unusable output buffer: dropping");
+                    buf = NULL;
+                }
+                else
+                {
+                    ret = gst_pad_alloc_buffer_and_set_caps (self->srcpad,
+                                                             GST_BUFFER_OFFSET_NONE,
+                                                             size,
+                                                             GST_PAD_CAPS (self->srcpad),
+                                                             &buf);
+                }
 
                 if (G_LIKELY (buf))
                 {
-                    memcpy (GST_BUFFER_DATA (buf), omx_buffer->pBuffer + omx_buffer->nOffset, omx_buffer->nFilledLen);
+                    if (self->out_copy)
+                        self->out_copy (self, GST_BUFFER_DATA (buf), omx_buffer);
+                    else
+                        memcpy (GST_BUFFER_DATA (buf), omx_buffer->pBuffer + omx_buffer->nOffset, omx_buffer->nFilledLen);
                     if (self->use_timestamps)
                     {
                         GST_BUFFER_TIMESTAMP (buf) = gst_util_uint64_scale_int (omx_buffer->nTimeStamp,
@@ -430,12 +478,12 @@ output_loop (gpointer data)
                         }
                     }
 
-                    ret = push_buffer (self, buf);
+                    ret = push_buffer (self, buf, omx_buffer);
                 }
-                else
+                else if (size > 0)
                 {
                     GST_WARNING_OBJECT (self, "couldn't allocate buffer of size %d",
-                                        omx_buffer->nFilledLen);
+                                        size);
                 }
             }
         }
@@ -444,9 +492,17 @@ output_loop (gpointer data)
             GST_WARNING_OBJECT (self, "empty buffer");
         }
 
-        if (G_UNLIKELY (omx_buffer->nFlags & OMX_BUFFERFLAG_EOS))
+        if (G_UNLIKELY (omx_buffer->nFlags & OMX_BUFFERFLAG_EOS) &&
+            self->image_eos && !g_atomic_int_get (&self->input_eos))
+        {
+            /* more images to come */
+            GST_LOG_OBJECT (self, "end of image");
+        }
+        else if (G_UNLIKELY (omx_buffer->nFlags & OMX_BUFFERFLAG_EOS))
         {
             GST_DEBUG_OBJECT (self, "got eos");
+            if (self->drain_output)
+                self->drain_output (self);
             gst_pad_push_event (self->srcpad, gst_event_new_eos ());
             ret = GST_FLOW_UNEXPECTED;
             goto leave;
@@ -598,6 +654,9 @@ pad_chain (GstPad *pad,
             GST_ERROR_OBJECT (self, "Whoa! very wrong");
         }
 
+        if (self->prepare_input)
+            self->prepare_input (self, buf);
+
         while (G_LIKELY (buffer_offset < GST_BUFFER_SIZE (buf)))
         {
             OMX_BUFFERHEADERTYPE *omx_buffer;
@@ -621,7 +680,9 @@ pad_chain (GstPad *pad,
                                   omx_buffer->nOffset, omx_buffer->nTimeStamp);
 
                 if (omx_buffer->nOffset == 0 &&
-                    self->share_input_buffer)
+                    self->share_input_buffer &&
+                    !self->in_copy &&
+                    !self->in_slice_size)
                 {
                     {
                         GstBuffer *old_buf;
@@ -646,7 +707,12 @@ pad_chain (GstPad *pad,
                 {
                     omx_buffer->nFilledLen = MIN (GST_BUFFER_SIZE (buf) - buffer_offset,
                                                   omx_buffer->nAllocLen - omx_buffer->nOffset);
-                    memcpy (omx_buffer->pBuffer + omx_buffer->nOffset, GST_BUFFER_DATA (buf) + buffer_offset, omx_buffer->nFilledLen);
+                    if (self->in_slice_size)
+                        omx_buffer->nFilledLen = MIN (omx_buffer->nFilledLen, self->in_slice_size);
+                    if (self->in_copy)
+                        self->in_copy (self, omx_buffer->pBuffer + omx_buffer->nOffset, buf, buffer_offset, omx_buffer->nFilledLen);
+                    else
+                        memcpy (omx_buffer->pBuffer + omx_buffer->nOffset, GST_BUFFER_DATA (buf) + buffer_offset, omx_buffer->nFilledLen);
                 }
 
                 if (self->use_timestamps)
@@ -667,6 +733,24 @@ pad_chain (GstPad *pad,
 
                 buffer_offset += omx_buffer->nFilledLen;
 
+                if (self->decode_only)
+                    omx_buffer->nFlags |= OMX_BUFFERFLAG_DECODEONLY;
+                else
+                    omx_buffer->nFlags &= ~OMX_BUFFERFLAG_DECODEONLY;
+
+                if (self->in_sync_flags && !GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT))
+                    omx_buffer->nFlags |= OMX_BUFFERFLAG_SYNCFRAME;
+                else
+                    omx_buffer->nFlags &= ~OMX_BUFFERFLAG_SYNCFRAME;
+
+                if (self->frame_aligned_input)
+                {
+                    if (buffer_offset == GST_BUFFER_SIZE (buf))
+                        omx_buffer->nFlags |= OMX_BUFFERFLAG_ENDOFFRAME;
+                    else
+                        omx_buffer->nFlags &= ~OMX_BUFFERFLAG_ENDOFFRAME;
+                }
+
                 GST_LOG_OBJECT (self, "release_buffer");
                 /** @todo untaint buffer */
                 g_omx_port_release_buffer (in_port, omx_buffer);
@@ -759,6 +843,7 @@ pad_event (GstPad *pad,
                     if (G_LIKELY (omx_buffer))
                     {
                         omx_buffer->nFlags |= OMX_BUFFERFLAG_EOS;
+                        g_atomic_int_set (&self->input_eos, TRUE);
 
                         GST_LOG_OBJECT (self, "release_buffer");
                         /* foo_buffer_untaint (omx_buffer); */
@@ -788,6 +873,7 @@ pad_event (GstPad *pad,
         case GST_EVENT_FLUSH_STOP:
             gst_pad_push_event (self->srcpad, event);
             self->last_pad_push_return = GST_FLOW_OK;
+            g_atomic_int_set (&self->input_eos, FALSE);
 
             g_omx_core_flush_stop (gomx);
 
@@ -37,6 +37,13 @@ typedef void (*GstOmxBaseFilterCb) (GstOmxBaseFilter *self);
 #include "gstomx_util.h"
 #include <async_queue.h>
 
+typedef void (*GstOmxBaseFilterBufferCb) (GstOmxBaseFilter *self, GstBuffer *buf);
+typedef void (*GstOmxBaseFilterOutputCb) (GstOmxBaseFilter *self, GstBuffer *buf, OMX_BUFFERHEADERTYPE *omx_buffer);
+typedef guint (*GstOmxBaseFilterSizeCb) (GstOmxBaseFilter *self, OMX_BUFFERHEADERTYPE *omx_buffer);
+typedef void (*GstOmxBaseFilterCopyCb) (GstOmxBaseFilter *self, guint8 *dest, OMX_BUFFERHEADERTYPE *omx_buffer);
+typedef void (*GstOmxBaseFilterInCopyCb) (GstOmxBaseFilter *self, guint8 *dest, GstBuffer *buf, guint offset, guint size);
+typedef GstFlowReturn (*GstOmxBaseFilterPushCb) (GstOmxBaseFilter *self, GstBuffer *buf, OMX_BUFFERHEADERTYPE *omx_buffer);
+
 struct GstOmxBaseFilter
 {
     GstElement element;
@@ -55,6 +62,20 @@ struct GstOmxBaseFilter
     GMutex *ready_lock;
 
     GstOmxBaseFilterCb omx_setup;
+    GstOmxBaseFilterBufferCb prepare_input; /**< Called before each buffer is sent to OpenMAX */
+    GstOmxBaseFilterOutputCb prepare_output; /**< Called before each output buffer is pushed */
+    GstOmxBaseFilterPushCb push_output; /**< Push (or hold back) output, instead of gst_pad_push */
+    GstOmxBaseFilterCb drain_output; /**< Push whatever push_output held back, before EOS */
+    GstOmxBaseFilterSizeCb out_size; /**< Size of the data out_copy produces; 0 drops the buffer */
+    GstOmxBaseFilterCopyCb out_copy; /**< Copy (and convert) output data, instead of memcpy */
+    GstOmxBaseFilterInCopyCb in_copy; /**< Copy (and convert) input data, instead of memcpy */
+    gboolean frame_aligned_input; /**< Each input buffer holds exactly one frame */
+    guint in_slice_size; /**< Fill OpenMAX input buffers with at most this much, if set */
+    gboolean decode_only; /**< Current input is decoded but not shown */
+    gboolean in_sync_flags; /**< Tell the component which input buffers are sync frames */
+    gboolean out_sync_flags; /**< Component marks its sync frames on output */
+    gboolean image_eos; /**< Output EOS flags only end an image, until input EOS */
+    gint input_eos; /**< EOS was passed to the component */
     GstFlowReturn last_pad_push_return;
     GstBuffer *codec_data;
 
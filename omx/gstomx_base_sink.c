@@ -28,8 +28,6 @@
 
 #include <string.h> /* for memset, memcpy */
 
-static gboolean share_input_buffer;
-
 static inline gboolean omx_init (GstOmxBaseSink *self);
 
 enum
@@ -37,6 +35,7 @@ enum
     ARG_0,
     ARG_COMPONENT_NAME,
     ARG_LIBRARY_NAME,
+    ARG_ZERO_COPY,
 };
 
 static GstElementClass *parent_class;
@@ -62,6 +61,30 @@ setup_ports (GstOmxBaseSink *self)
     gst_pad_set_element_private (self->sinkpad, self->in_port);
 }
 
+/* Drops the GstBuffers the component was handed in zero-copy mode. */
+static void
+release_shared_buffers (GstOmxBaseSink *self)
+{
+    guint i;
+
+    if (!self->in_port || !self->in_port->buffers)
+        return;
+
+    for (i = 0; i < self->in_port->num_buffers; i++)
+    {
+        OMX_BUFFERHEADERTYPE *omx_buffer;
+
+        omx_buffer = self->in_port->buffers[i];
+
+        if (omx_buffer && omx_buffer->pAppPrivate)
+        {
+            gst_buffer_unref (omx_buffer->pAppPrivate);
+            omx_buffer->pAppPrivate = NULL;
+            omx_buffer->pBuffer = NULL;
+        }
+    }
+}
+
 static GstStateChangeReturn
 change_state (GstElement *element,
               GstStateChange transition)
@@ -79,6 +102,10 @@ change_state (GstElement *element,
 
     switch (transition)
     {
+        case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+            g_omx_port_resume (self->in_port);
+            break;
+
         case GST_STATE_CHANGE_NULL_TO_READY:
             if (!self->initialized)
             {
@@ -87,12 +114,6 @@ change_state (GstElement *element,
 
                 self->initialized = TRUE;
             }
-
-            g_omx_core_prepare (self->gomx);
-            break;
-
-        case GST_STATE_CHANGE_READY_TO_PAUSED:
-            g_omx_core_start (self->gomx);
             break;
 
         case GST_STATE_CHANGE_PAUSED_TO_READY:
@@ -116,6 +137,13 @@ change_state (GstElement *element,
 
         case GST_STATE_CHANGE_PAUSED_TO_READY:
             g_omx_core_stop (self->gomx);
+            /* the component has returned every buffer */
+            release_shared_buffers (self);
+            /* back to Loaded, so the next run is set up for its caps */
+            g_omx_core_unload (self->gomx);
+            if (self->in_port)
+                async_queue_flush (self->in_port->queue);
+            self->ready = FALSE;
             break;
 
         case GST_STATE_CHANGE_READY_TO_NULL:
@@ -147,6 +175,41 @@ finalize (GObject *obj)
     G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
 
+/* The buffers are sized once the caps are known, so the component is
+ * only prepared when the first buffer arrives. */
+static gboolean
+omx_start (GstOmxBaseSink *self)
+{
+    GOmxCore *gomx;
+
+    gomx = self->gomx;
+
+    if (gomx->omx_state == OMX_StateLoaded)
+    {
+        GST_INFO_OBJECT (self, "omx: prepare");
+
+        if (self->omx_setup)
+            self->omx_setup (self);
+
+        setup_ports (self);
+
+        /* g_omx_port_finish disabled it when the last run stopped */
+        self->in_port->enabled = TRUE;
+
+        g_omx_core_prepare (gomx);
+    }
+
+    if (gomx->omx_state == OMX_StateIdle)
+    {
+        GST_INFO_OBJECT (self, "omx: play");
+        g_omx_core_start (gomx);
+    }
+
+    self->ready = (gomx->omx_state == OMX_StateExecuting);
+
+    return self->ready;
+}
+
 static GstFlowReturn
 render (GstBaseSink *gst_base,
         GstBuffer *buf)
@@ -165,8 +228,22 @@ render (GstBaseSink *gst_base,
 
     GST_LOG_OBJECT (self, "state: %d", gomx->omx_state);
 
+    if (G_UNLIKELY (!self->ready))
+    {
+        if (!omx_start (self))
+        {
+            GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+                               ("Unable to start the component"));
+            return GST_FLOW_ERROR;
+        }
+    }
+
     in_port = self->in_port;
 
+    /* the header memory is replaced, so it must be ours; and the data
+     * has to go in as it is, which new caps may have changed */
+    self->share_input_buffer = self->zero_copy && !in_port->omx_allocate && !self->in_copy;
+
     if (G_LIKELY (in_port->enabled))
     {
         guint buffer_offset = 0;
@@ -180,13 +257,27 @@ render (GstBaseSink *gst_base,
 
             if (G_LIKELY (omx_buffer))
             {
+                guint used;
+
                 GST_DEBUG_OBJECT (self, "omx_buffer: size=%lu, len=%lu, flags=%lu, offset=%lu, timestamp=%lld",
                                   omx_buffer->nAllocLen, omx_buffer->nFilledLen, omx_buffer->nFlags,
                                   omx_buffer->nOffset, omx_buffer->nTimeStamp);
 
-                if (omx_buffer->nOffset == 0 &&
-                    share_input_buffer)
+                if (!self->share_input_buffer && G_UNLIKELY (omx_buffer->pAppPrivate))
+                {
+                    /* shared before the caps changed; the memory the
+                     * header came with is gone */
+                    gst_buffer_unref (omx_buffer->pAppPrivate);
+                    omx_buffer->pAppPrivate = NULL;
+                    omx_buffer->pBuffer = g_malloc (in_port->buffer_size);
+                    omx_buffer->nOffset = 0;
+                    omx_buffer->nAllocLen = in_port->buffer_size;
+                }
+
+                if (self->share_input_buffer)
                 {
+                    /* the header is back from EmptyBufferDone, so the
+                     * previous buffer can go */
                     {
                         GstBuffer *old_buf;
                         old_buf = omx_buffer->pAppPrivate;
@@ -205,27 +296,42 @@ render (GstBaseSink *gst_base,
                     gst_buffer_ref (buf);
 
                     omx_buffer->pBuffer = GST_BUFFER_DATA (buf);
+                    omx_buffer->nOffset = 0;
                     omx_buffer->nAllocLen = GST_BUFFER_SIZE (buf);
                     omx_buffer->nFilledLen = GST_BUFFER_SIZE (buf);
                     omx_buffer->pAppPrivate = buf;
+                    used = omx_buffer->nFilledLen;
+                }
+                else if (self->in_copy)
+                {
+                    used = self->in_copy (self, omx_buffer,
+                                          GST_BUFFER_DATA (buf) + buffer_offset,
+                                          GST_BUFFER_SIZE (buf) - buffer_offset);
                 }
                 else
                 {
                     omx_buffer->nFilledLen = MIN (GST_BUFFER_SIZE (buf) - buffer_offset,
                                                   omx_buffer->nAllocLen - omx_buffer->nOffset);
                     memcpy (omx_buffer->pBuffer + omx_buffer->nOffset, GST_BUFFER_DATA (buf) + buffer_offset, omx_buffer->nFilledLen);
+                    used = omx_buffer->nFilledLen;
                 }
 
+                if (self->submit_buffer)
+                    self->submit_buffer (self, omx_buffer);
+
                 GST_LOG_OBJECT (self, "release_buffer");
                 g_omx_port_release_buffer (in_port, omx_buffer);
 
-                buffer_offset += omx_buffer->nFilledLen;
+                buffer_offset += used;
             }
             else
             {
-                GST_WARNING_OBJECT (self, "null buffer");
-                ret = GST_FLOW_UNEXPECTED;
-                break;
+                /* paused or flushing; carry on once playing again, the
+                 * port is resumed before that */
+                GST_DEBUG_OBJECT (self, "null buffer");
+                ret = gst_base_sink_wait_preroll (gst_base);
+                if (ret != GST_FLOW_OK)
+                    break;
             }
         }
     }
@@ -240,6 +346,30 @@ render (GstBaseSink *gst_base,
     return ret;
 }
 
+/* Only gets the component going; render submits the same buffer. */
+static GstFlowReturn
+preroll (GstBaseSink *gst_base,
+         GstBuffer *buf)
+{
+    GstOmxBaseSink *self;
+
+    self = GST_OMX_BASE_SINK (gst_base);
+
+    GST_LOG_OBJECT (self, "preroll: size=%lu", GST_BUFFER_SIZE (buf));
+
+    if (G_UNLIKELY (!self->ready))
+    {
+        if (!omx_start (self))
+        {
+            GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+                               ("Unable to start the component"));
+            return GST_FLOW_ERROR;
+        }
+    }
+
+    return GST_FLOW_OK;
+}
+
 static gboolean
 handle_event (GstBaseSink *gst_base,
               GstEvent *event)
@@ -268,11 +398,13 @@ handle_event (GstBaseSink *gst_base,
             g_omx_port_pause (in_port);
 
             /* flush all buffers */
-            OMX_SendCommand (gomx->omx_handle, OMX_CommandFlush, OMX_ALL, NULL);
+            if (self->ready)
+                OMX_SendCommand (gomx->omx_handle, OMX_CommandFlush, OMX_ALL, NULL);
             break;
 
         case GST_EVENT_FLUSH_STOP:
-            g_sem_down (gomx->flush_sem);
+            if (self->ready)
+                g_sem_down (gomx->flush_sem);
 
             g_omx_port_resume (in_port);
             break;
@@ -306,6 +438,9 @@ set_property (GObject *obj,
             g_free (self->omx_library);
             self->omx_library = g_value_dup_string (value);
             break;
+        case ARG_ZERO_COPY:
+            self->zero_copy = g_value_get_boolean (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -330,6 +465,9 @@ get_property (GObject *obj,
         case ARG_LIBRARY_NAME:
             g_value_set_string (value, self->omx_library);
             break;
+        case ARG_ZERO_COPY:
+            g_value_set_boolean (value, self->zero_copy);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -348,14 +486,14 @@ type_class_init (gpointer g_class,
     gst_base_sink_class = GST_BASE_SINK_CLASS (g_class);
     gstelement_class = GST_ELEMENT_CLASS (g_class);
 
-    parent_class = g_type_class_ref (GST_TYPE_ELEMENT);
+    parent_class = g_type_class_ref (GST_TYPE_BASE_SINK);
 
     gobject_class->finalize = finalize;
 
     gstelement_class->change_state = change_state;
 
     gst_base_sink_class->event = handle_event;
-    gst_base_sink_class->preroll = render;
+    gst_base_sink_class->preroll = preroll;
     gst_base_sink_class->render = render;
 
     /* Properties stuff */
@@ -372,6 +510,11 @@ type_class_init (gpointer g_class,
                                          g_param_spec_string ("library-name", "Library name",
                                                               "Name of the OpenMAX IL implementation library to use",
                                                               NULL, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_ZERO_COPY,
+                                         g_param_spec_boolean ("zero-copy", "Zero copy",
+                                                               "Hand the buffer data to the component instead of copying it",
+                                                               FALSE, G_PARAM_READWRITE));
     }
 }
 
@@ -37,6 +37,9 @@ typedef void (*GstOmxBaseSinkCb) (GstOmxBaseSink *self);
 
 #include <gstomx_util.h>
 
+typedef void (*GstOmxBaseSinkBufferCb) (GstOmxBaseSink *self, OMX_BUFFERHEADERTYPE *omx_buffer);
+typedef guint (*GstOmxBaseSinkCopyCb) (GstOmxBaseSink *self, OMX_BUFFERHEADERTYPE *omx_buffer, const guint8 *src, guint size);
+
 struct GstOmxBaseSink
 {
     GstBaseSink element;
@@ -52,6 +55,13 @@ struct GstOmxBaseSink
     gboolean ready;
     GstPadActivateModeFunction base_activatepush;
     gboolean initialized;
+
+    gboolean zero_copy; /**< Property; takes effect when the buffers are allocated */
+    gboolean share_input_buffer; /**< Give the component the GstBuffer data itself */
+
+    GstOmxBaseSinkCb omx_setup; /**< Before the buffers are allocated */
+    GstOmxBaseSinkBufferCb submit_buffer; /**< Just before a filled buffer goes to the component */
+    GstOmxBaseSinkCopyCb in_copy; /**< Fill (and convert) instead of memcpy; returns the input used */
 };
 
 struct GstOmxBaseSinkClass
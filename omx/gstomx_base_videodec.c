@@ -20,12 +20,85 @@
  */
 
 #include "gstomx_base_videodec.h"
+#include "gstomx_convert.h"
+#include "gstomx_bitstream.h"
 #include "gstomx.h"
 
-#include <string.h> /* for memset */
+#include <string.h> /* for memset, memcpy, strcmp */
+#include <stdlib.h> /* for qsort */
+
+enum
+{
+    ARG_0,
+    ARG_FRAMING,
+    ARG_SKIP_FRAMES,
+    ARG_ERROR_POLICY,
+    ARG_CONCEALED_FRAMES,
+    ARG_CORRUPT_FRAMES,
+};
+
+enum
+{
+    SKIP_NONE,
+    SKIP_NON_REFERENCE,
+    SKIP_NON_KEYFRAME,
+};
+
+enum
+{
+    ERROR_PASS,
+    ERROR_DROP_UNTIL_KEYFRAME,
+    ERROR_FAIL,
+};
+
+#define DEFAULT_FRAMING FALSE
+#define DEFAULT_SKIP_FRAMES SKIP_NONE
+#define DEFAULT_ERROR_POLICY ERROR_PASS
 
 static GstOmxBaseFilterClass *parent_class;
 
+#define GST_TYPE_OMX_VIDEODEC_SKIP_FRAMES (gst_omx_videodec_skip_frames_get_type ())
+static GType
+gst_omx_videodec_skip_frames_get_type (void)
+{
+    static GType gst_omx_videodec_skip_frames_type = 0;
+
+    if (!gst_omx_videodec_skip_frames_type) {
+        static GEnumValue gst_omx_videodec_skip_frames[] = {
+            {SKIP_NONE, "Decode all frames", "none"},
+            {SKIP_NON_REFERENCE, "Skip frames not used as reference", "non-reference"},
+            {SKIP_NON_KEYFRAME, "Decode only keyframes", "non-keyframe"},
+            {0, NULL, NULL},
+        };
+
+        gst_omx_videodec_skip_frames_type = g_enum_register_static ("GstOmxVideoDecSkipFrames",
+                                                                    gst_omx_videodec_skip_frames);
+    }
+
+    return gst_omx_videodec_skip_frames_type;
+}
+
+#define GST_TYPE_OMX_VIDEODEC_ERROR_POLICY (gst_omx_videodec_error_policy_get_type ())
+static GType
+gst_omx_videodec_error_policy_get_type (void)
+{
+    static GType gst_omx_videodec_error_policy_type = 0;
+
+    if (!gst_omx_videodec_error_policy_type) {
+        static GEnumValue gst_omx_videodec_error_policy[] = {
+            {ERROR_PASS, "Output concealed frames", "pass"},
+            {ERROR_DROP_UNTIL_KEYFRAME, "Drop frames until the next keyframe", "drop-until-keyframe"},
+            {ERROR_FAIL, "Stop with an error", "fail"},
+            {0, NULL, NULL},
+        };
+
+        gst_omx_videodec_error_policy_type = g_enum_register_static ("GstOmxVideoDecErrorPolicy",
+                                                                     gst_omx_videodec_error_policy);
+    }
+
+    return gst_omx_videodec_error_policy_type;
+}
+
 static GstCaps *
 generate_src_template (void)
 {
@@ -58,6 +131,9 @@ generate_src_template (void)
         gst_value_set_fourcc (&val, GST_MAKE_FOURCC ('U', 'Y', 'V', 'Y'));
         gst_value_list_append_value (&list, &val);
 
+        gst_value_set_fourcc (&val, GST_MAKE_FOURCC ('N', 'V', '1', '2'));
+        gst_value_list_append_value (&list, &val);
+
         gst_structure_set_value (struc, "format", &list);
 
         g_value_unset (&val);
@@ -69,6 +145,233 @@ generate_src_template (void)
     return caps;
 }
 
+/*
+ * Capabilities probing
+ *
+ * Loading the component to see what it supports is slow, so it's only
+ * done when the registry is built; afterwards the pad templates stored
+ * in the registry are used.
+ */
+
+static GstCaps *
+get_cached_caps (gpointer g_class,
+                 const gchar *name)
+{
+    GstElementFactory *factory;
+    const GList *l;
+
+    factory = GST_ELEMENT_CLASS (g_class)->elementfactory;
+    if (!factory)
+        return NULL;
+
+    for (l = gst_element_factory_get_static_pad_templates (factory); l; l = l->next)
+    {
+        GstStaticPadTemplate *template = l->data;
+
+        if (strcmp (template->name_template, name) == 0)
+            return gst_caps_copy (gst_static_caps_get (&template->static_caps));
+    }
+
+    return NULL;
+}
+
+static gboolean
+get_component (gpointer g_class,
+               const gchar **library_name,
+               const gchar **component_name)
+{
+    GType type;
+
+    type = G_TYPE_FROM_CLASS (g_class);
+
+    *library_name = g_type_get_qdata (type, g_quark_from_static_string ("library-name"));
+    *component_name = g_type_get_qdata (type, g_quark_from_static_string ("component-name"));
+
+    return *library_name && *component_name;
+}
+
+static void
+set_field (GstCaps *caps,
+           const gchar *field,
+           const GValue *value)
+{
+    guint i;
+
+    for (i = 0; i < gst_caps_get_size (caps); i++)
+        gst_structure_set_value (gst_caps_get_structure (caps, i), field, value);
+}
+
+static GstCaps *
+probe_src_caps (gpointer g_class,
+                GstCaps *caps)
+{
+    GstCaps *cached;
+    const gchar *library_name;
+    const gchar *component_name;
+    GArray *color_formats;
+    GValue list = { 0 };
+    GValue val = { 0 };
+    guint i;
+
+    cached = get_cached_caps (g_class, "src");
+    if (cached)
+    {
+        gst_caps_unref (caps);
+        return cached;
+    }
+
+    if (!get_component (g_class, &library_name, &component_name))
+        return caps;
+
+    color_formats = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    if (!g_omx_probe_port (library_name, component_name, 1, NULL, color_formats))
+        goto leave;
+
+    g_value_init (&list, GST_TYPE_LIST);
+    g_value_init (&val, GST_TYPE_FOURCC);
+
+    for (i = 0; i < color_formats->len; i++)
+    {
+        switch (g_array_index (color_formats, guint, i))
+        {
+            case OMX_COLOR_FormatYUV420Planar:
+                gst_value_set_fourcc (&val, GST_MAKE_FOURCC ('I', '4', '2', '0'));
+                gst_value_list_append_value (&list, &val);
+                break;
+            case OMX_COLOR_FormatYCbYCr:
+                gst_value_set_fourcc (&val, GST_MAKE_FOURCC ('Y', 'U', 'Y', '2'));
+                gst_value_list_append_value (&list, &val);
+                break;
+            case OMX_COLOR_FormatCbYCrY:
+                gst_value_set_fourcc (&val, GST_MAKE_FOURCC ('U', 'Y', 'V', 'Y'));
+                gst_value_list_append_value (&list, &val);
+                break;
+            case OMX_COLOR_FormatYUV420SemiPlanar:
+            case OMX_COLOR_FormatYUV420PackedSemiPlanar:
+                gst_value_set_fourcc (&val, GST_MAKE_FOURCC ('N', 'V', '1', '2'));
+                gst_value_list_append_value (&list, &val);
+                /* we can convert it */
+                gst_value_set_fourcc (&val, GST_MAKE_FOURCC ('I', '4', '2', '0'));
+                gst_value_list_append_value (&list, &val);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (gst_value_list_get_size (&list) > 0)
+        set_field (caps, "format", &list);
+
+    g_value_unset (&val);
+    g_value_unset (&list);
+
+leave:
+    g_array_free (color_formats, TRUE);
+
+    return caps;
+}
+
+/* Restricts the profile and level fields of the sink caps to what the
+ * component supports; one structure per profile, since the levels it
+ * goes up to differ. */
+GstCaps *
+gst_omx_base_videodec_probe_sink_caps (gpointer g_class,
+                                       GstCaps *caps,
+                                       const GstOmxVideoName *profiles,
+                                       const GstOmxVideoName *levels)
+{
+    GstCaps *cached;
+    GstCaps *result;
+    const gchar *library_name;
+    const gchar *component_name;
+    GArray *profile_levels;
+    guint i;
+    guint j;
+
+    cached = get_cached_caps (g_class, "sink");
+    if (cached)
+    {
+        gst_caps_unref (caps);
+        return cached;
+    }
+
+    if (!get_component (g_class, &library_name, &component_name))
+        return caps;
+
+    profile_levels = g_array_new (FALSE, FALSE, sizeof (GOmxProfileLevel));
+
+    if (!g_omx_probe_port (library_name, component_name, 0, profile_levels, NULL) ||
+        profile_levels->len == 0)
+        goto leave;
+
+    result = gst_caps_new_empty ();
+
+    for (j = 0; profiles[j].name; j++)
+    {
+        GstCaps *profile_caps;
+        GValue list = { 0 };
+        GValue val = { 0 };
+        gboolean supported = FALSE;
+        guint max_level = 0;
+        guint k;
+
+        for (i = 0; i < profile_levels->len; i++)
+        {
+            GOmxProfileLevel *profile_level;
+
+            profile_level = &g_array_index (profile_levels, GOmxProfileLevel, i);
+            if (profile_level->profile == profiles[j].omx_value)
+            {
+                supported = TRUE;
+                max_level = MAX (max_level, profile_level->level);
+            }
+        }
+
+        if (!supported)
+            continue;
+
+        profile_caps = gst_caps_copy (caps);
+
+        g_value_init (&val, G_TYPE_STRING);
+        g_value_set_static_string (&val, profiles[j].name);
+        set_field (profile_caps, "profile", &val);
+
+        g_value_init (&list, GST_TYPE_LIST);
+
+        for (k = 0; levels[k].name; k++)
+        {
+            if (levels[k].omx_value <= max_level)
+            {
+                g_value_set_static_string (&val, levels[k].name);
+                gst_value_list_append_value (&list, &val);
+            }
+        }
+
+        if (gst_value_list_get_size (&list) > 0)
+            set_field (profile_caps, "level", &list);
+
+        g_value_unset (&val);
+        g_value_unset (&list);
+
+        gst_caps_append (result, profile_caps);
+    }
+
+    if (gst_caps_is_empty (result))
+    {
+        gst_caps_unref (result);
+        goto leave;
+    }
+
+    gst_caps_unref (caps);
+    caps = result;
+
+leave:
+    g_array_free (profile_levels, TRUE);
+
+    return caps;
+}
+
 static void
 type_base_init (gpointer g_class)
 {
@@ -81,17 +384,188 @@ type_base_init (gpointer g_class)
 
         template = gst_pad_template_new ("src", GST_PAD_SRC,
                                          GST_PAD_ALWAYS,
-                                         generate_src_template ());
+                                         probe_src_caps (g_class, generate_src_template ()));
 
         gst_element_class_add_pad_template (element_class, template);
     }
 }
 
+static void
+finalize (GObject *obj)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (obj);
+
+    g_object_unref (self->adapter);
+
+    G_OBJECT_CLASS (parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject *obj,
+              guint prop_id,
+              const GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (obj);
+
+    switch (prop_id)
+    {
+        case ARG_FRAMING:
+            self->framing = g_value_get_boolean (value);
+            break;
+        case ARG_SKIP_FRAMES:
+            self->skip_frames = g_value_get_enum (value);
+            break;
+        case ARG_ERROR_POLICY:
+            self->error_policy = g_value_get_enum (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+get_property (GObject *obj,
+              guint prop_id,
+              GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (obj);
+
+    switch (prop_id)
+    {
+        case ARG_FRAMING:
+            g_value_set_boolean (value, self->framing);
+            break;
+        case ARG_SKIP_FRAMES:
+            g_value_set_enum (value, self->skip_frames);
+            break;
+        case ARG_ERROR_POLICY:
+            g_value_set_enum (value, self->error_policy);
+            break;
+        case ARG_CONCEALED_FRAMES:
+            g_value_set_uint (value, g_atomic_int_get (&self->concealed_frames));
+            break;
+        case ARG_CORRUPT_FRAMES:
+            g_value_set_uint (value, g_atomic_int_get (&self->corrupt_frames));
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
 static void
 type_class_init (gpointer g_class,
                  gpointer class_data)
 {
+    GObjectClass *gobject_class;
+
+    gobject_class = G_OBJECT_CLASS (g_class);
+
     parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+
+    gobject_class->finalize = finalize;
+
+    /* Properties stuff */
+    {
+        gobject_class->set_property = set_property;
+        gobject_class->get_property = get_property;
+
+        g_object_class_install_property (gobject_class, ARG_FRAMING,
+                                         g_param_spec_boolean ("framing", "Framing",
+                                                               "Split the input in frames, one per OpenMAX buffer",
+                                                               DEFAULT_FRAMING, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_SKIP_FRAMES,
+                                         g_param_spec_enum ("skip-frames", "Skip frames",
+                                                            "Frames to drop before decoding; needs input split in frames",
+                                                            GST_TYPE_OMX_VIDEODEC_SKIP_FRAMES,
+                                                            DEFAULT_SKIP_FRAMES,
+                                                            G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_ERROR_POLICY,
+                                         g_param_spec_enum ("error-policy", "Error policy",
+                                                            "What to do after a corrupt or concealed frame; dropping needs input split in frames",
+                                                            GST_TYPE_OMX_VIDEODEC_ERROR_POLICY,
+                                                            DEFAULT_ERROR_POLICY,
+                                                            G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_CONCEALED_FRAMES,
+                                         g_param_spec_uint ("concealed-frames", "Concealed frames",
+                                                            "Frames with macroblock errors the component concealed",
+                                                            0, G_MAXUINT, 0, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_CORRUPT_FRAMES,
+                                         g_param_spec_uint ("corrupt-frames", "Corrupt frames",
+                                                            "Corrupt stream errors reported by the component",
+                                                            0, G_MAXUINT, 0, G_PARAM_READABLE));
+    }
+}
+
+static guint
+out_size (GstOmxBaseFilter *omx_base,
+          OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (omx_base);
+
+    /* a short buffer would be read past its data */
+    if (omx_buffer->nFilledLen < g_omx_convert_nv12_size (self->stride, self->slice_height,
+                                                          self->width, self->height))
+    {
+        GST_WARNING_OBJECT (self, "short NV12 buffer: %lu bytes", omx_buffer->nFilledLen);
+        return 0;
+    }
+
+    return g_omx_convert_i420_size (self->width, self->height);
+}
+
+static void
+out_copy (GstOmxBaseFilter *omx_base,
+          guint8 *dest,
+          OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (omx_base);
+
+    g_omx_convert_nv12_to_i420 (omx_buffer->pBuffer + omx_buffer->nOffset,
+                                self->stride, self->slice_height,
+                                dest, self->width, self->height);
+}
+
+/* From the caps, or else estimated; 0/1 when unknown. */
+static void
+get_framerate (GstOmxBaseVideoDec *self,
+               gint *num,
+               gint *denom)
+{
+    GST_OBJECT_LOCK (self);
+    if (self->framerate_num > 0 && self->framerate_denom > 0)
+    {
+        *num = self->framerate_num;
+        *denom = self->framerate_denom;
+    }
+    else if (self->estimated_num > 0)
+    {
+        *num = self->estimated_num;
+        *denom = self->estimated_denom;
+    }
+    else
+    {
+        *num = 0;
+        *denom = 1;
+    }
+    GST_OBJECT_UNLOCK (self);
 }
 
 static void
@@ -102,6 +576,8 @@ settings_changed_cb (GOmxCore *core)
     guint width;
     guint height;
     guint32 format = 0;
+    gint framerate_num;
+    gint framerate_denom;
 
     omx_base = core->object;
     self = GST_OMX_BASE_VIDEODEC (omx_base);
@@ -130,11 +606,22 @@ settings_changed_cb (GOmxCore *core)
                 format = GST_MAKE_FOURCC ('Y', 'U', 'Y', '2'); break;
             case OMX_COLOR_FormatCbYCrY:
                 format = GST_MAKE_FOURCC ('U', 'Y', 'V', 'Y'); break;
+            case OMX_COLOR_FormatYUV420SemiPlanar:
+            case OMX_COLOR_FormatYUV420PackedSemiPlanar:
+                format = GST_MAKE_FOURCC ('N', 'V', '1', '2'); break;
             default:
                 break;
         }
+
+        self->width = width;
+        self->height = height;
+        self->stride = param.format.video.nStride > 0 ? param.format.video.nStride : 0;
+        self->slice_height = param.format.video.nSliceHeight;
     }
 
+    get_framerate (self, &framerate_num, &framerate_denom);
+    g_atomic_int_set (&self->framerate_changed, FALSE);
+
     {
         GstCaps *new_caps;
 
@@ -142,15 +629,70 @@ settings_changed_cb (GOmxCore *core)
                                         "width", G_TYPE_INT, width,
                                         "height", G_TYPE_INT, height,
                                         "framerate", GST_TYPE_FRACTION,
-                                        self->framerate_num, self->framerate_denom,
+                                        framerate_num, framerate_denom,
                                         "format", GST_TYPE_FOURCC, format,
                                         NULL);
 
+        self->convert_nv12 = FALSE;
+
+        /* deinterleave ourselves rather than require a colorspace element */
+        if (format == GST_MAKE_FOURCC ('N', 'V', '1', '2') &&
+            !gst_pad_peer_accept_caps (omx_base->srcpad, new_caps))
+        {
+            GstCaps *i420_caps;
+
+            i420_caps = gst_caps_copy (new_caps);
+            gst_caps_set_simple (i420_caps,
+                                 "format", GST_TYPE_FOURCC, GST_MAKE_FOURCC ('I', '4', '2', '0'),
+                                 NULL);
+
+            if (gst_pad_peer_accept_caps (omx_base->srcpad, i420_caps))
+            {
+                GST_INFO_OBJECT (omx_base, "downstream refuses NV12, converting to I420");
+                gst_caps_unref (new_caps);
+                new_caps = i420_caps;
+                self->convert_nv12 = TRUE;
+            }
+            else
+            {
+                gst_caps_unref (i420_caps);
+            }
+        }
+
+        omx_base->out_size = self->convert_nv12 ? out_size : NULL;
+        omx_base->out_copy = self->convert_nv12 ? out_copy : NULL;
+
         GST_INFO_OBJECT (omx_base, "caps are: %" GST_PTR_FORMAT, new_caps);
         gst_pad_set_caps (omx_base->srcpad, new_caps);
     }
 }
 
+/* Whether upstream already sends one access unit per buffer. */
+static gboolean
+input_aligned (GstOmxBaseVideoDec *self,
+               GstStructure *structure)
+{
+    const gchar *alignment;
+    gboolean parsed;
+
+    alignment = gst_structure_get_string (structure, "alignment");
+    if (alignment)
+        return strcmp (alignment, "au") == 0;
+
+    /* demuxed: containers store whole frames */
+    if (gst_structure_has_field (structure, "codec_data"))
+        return TRUE;
+
+    /* H.264 parsers may output single NAL units */
+    if (self->compression_format == OMX_VIDEO_CodingAVC)
+        return FALSE;
+
+    if (gst_structure_get_boolean (structure, "parsed", &parsed) && parsed)
+        return TRUE;
+
+    return gst_structure_get_boolean (structure, "framed", &parsed) && parsed;
+}
+
 static gboolean
 sink_setcaps (GstPad *pad,
               GstCaps *caps)
@@ -172,6 +714,22 @@ sink_setcaps (GstPad *pad,
 
     g_return_val_if_fail (gst_caps_get_size (caps) == 1, FALSE);
 
+    /* fail now, rather than halfway through the stream */
+    {
+        GstCaps *common;
+        gboolean supported;
+
+        common = gst_caps_intersect (caps, gst_pad_get_pad_template_caps (pad));
+        supported = !gst_caps_is_empty (common);
+        gst_caps_unref (common);
+
+        if (!supported)
+        {
+            GST_WARNING_OBJECT (self, "stream not supported by the component");
+            return FALSE;
+        }
+    }
+
     structure = gst_caps_get_structure (caps, 0);
 
     gst_structure_get_int (structure, "width", &width);
@@ -205,6 +763,9 @@ sink_setcaps (GstPad *pad,
         }
     }
 
+    self->aligned_input = input_aligned (self, structure);
+    GST_DEBUG_OBJECT (self, "aligned input: %d", self->aligned_input);
+
     /* Input port configuration. */
     {
         param.nPortIndex = 0;
@@ -219,6 +780,253 @@ sink_setcaps (GstPad *pad,
     return gst_pad_set_caps (pad, caps);
 }
 
+/*
+ * Frame timing
+ *
+ * Containers don't always tell the framerate, so it's estimated from the
+ * input timestamps. These come in decode order and with jitter; sorting a
+ * window of them and measuring the span without its ends cancels the
+ * reordering, and averages the jitter over many frames.
+ */
+
+#define TIMESTAMP_TRIM 4 /* reordering depth tolerated at each end */
+
+static const struct
+{
+    gint num;
+    gint denom;
+} common_framerates[] = {
+    {24000, 1001}, {24, 1}, {25, 1}, {30000, 1001}, {30, 1},
+    {50, 1}, {60000, 1001}, {60, 1},
+};
+
+static gint
+compare_timestamps (gconstpointer a,
+                    gconstpointer b)
+{
+    GstClockTime ta = *(const GstClockTime *) a;
+    GstClockTime tb = *(const GstClockTime *) b;
+
+    return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+static GstClockTime
+get_frame_duration (GstOmxBaseVideoDec *self)
+{
+    gint num;
+    gint denom;
+
+    get_framerate (self, &num, &denom);
+    if (num <= 0)
+        return GST_CLOCK_TIME_NONE;
+
+    return gst_util_uint64_scale_int (GST_SECOND, denom, num);
+}
+
+static void
+timing_reset (GstOmxBaseVideoDec *self)
+{
+    self->timestamp_count = 0;
+    self->next_interpolated = GST_CLOCK_TIME_NONE;
+}
+
+static void
+update_framerate (GstOmxBaseVideoDec *self,
+                  GstClockTime timestamp)
+{
+    GstClockTime sorted[G_N_ELEMENTS (self->timestamps)];
+    GstClockTime duration;
+    guint n;
+    gint num;
+    gint denom;
+    guint i;
+
+    if (self->framerate_num > 0)
+        return;
+
+    n = G_N_ELEMENTS (self->timestamps);
+
+    /* start over after a discontinuity */
+    if (self->timestamp_count > 0)
+    {
+        GstClockTime last;
+
+        last = self->timestamps[(self->timestamp_count - 1) % n];
+        if (timestamp > last + GST_SECOND || timestamp + GST_SECOND < last)
+            self->timestamp_count = 0;
+    }
+
+    self->timestamps[self->timestamp_count++ % n] = timestamp;
+    if (self->timestamp_count < n)
+        return;
+
+    memcpy (sorted, self->timestamps, sizeof (sorted));
+    qsort (sorted, n, sizeof (sorted[0]), compare_timestamps);
+
+    duration = (sorted[n - 1 - TIMESTAMP_TRIM] - sorted[TIMESTAMP_TRIM]) /
+        (n - 1 - 2 * TIMESTAMP_TRIM);
+
+    /* a discontinuity in the window shows as an outlying step */
+    {
+        GstClockTime steps[G_N_ELEMENTS (self->timestamps) - 1];
+        GstClockTime median;
+
+        for (i = 0; i < n - 1; i++)
+            steps[i] = sorted[i + 1] - sorted[i];
+        qsort (steps, n - 1, sizeof (steps[0]), compare_timestamps);
+        median = steps[(n - 1) / 2];
+
+        if (duration < GST_MSECOND || duration > GST_SECOND ||
+            duration > median + median / 4 || duration + median / 4 < median)
+            return;
+    }
+
+    /* don't renegotiate for every bit of jitter */
+    if (self->estimated_num > 0)
+    {
+        GstClockTime current;
+
+        current = gst_util_uint64_scale_int (GST_SECOND, self->estimated_denom,
+                                             self->estimated_num);
+        if (duration * 100 > current * 99 && duration * 100 < current * 101)
+            return;
+    }
+
+    num = (GST_SECOND * 1000 + duration / 2) / duration;
+    denom = 1000;
+
+    /* the nearest usual rate, if close enough */
+    {
+        GstClockTime best_error = duration / 50;
+
+        for (i = 0; i < G_N_ELEMENTS (common_framerates); i++)
+        {
+            GstClockTime common;
+            GstClockTime error;
+
+            common = gst_util_uint64_scale_int (GST_SECOND, common_framerates[i].denom,
+                                                common_framerates[i].num);
+            error = common > duration ? common - duration : duration - common;
+            if (error < best_error)
+            {
+                best_error = error;
+                num = common_framerates[i].num;
+                denom = common_framerates[i].denom;
+            }
+        }
+    }
+
+    GST_DEBUG_OBJECT (self, "estimated framerate: %d/%d", num, denom);
+
+    GST_OBJECT_LOCK (self);
+    self->estimated_num = num;
+    self->estimated_denom = denom;
+    GST_OBJECT_UNLOCK (self);
+
+    g_atomic_int_set (&self->framerate_changed, TRUE);
+}
+
+static void
+prepare_output (GstOmxBaseFilter *omx_base,
+                GstBuffer *buf,
+                OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (omx_base);
+
+    if (GST_PAD_CAPS (omx_base->srcpad) &&
+        g_atomic_int_compare_and_exchange (&self->framerate_changed, TRUE, FALSE))
+    {
+        GstCaps *caps;
+        gint num;
+        gint denom;
+
+        get_framerate (self, &num, &denom);
+
+        caps = gst_caps_copy (GST_PAD_CAPS (omx_base->srcpad));
+        gst_caps_set_simple (caps, "framerate", GST_TYPE_FRACTION, num, denom, NULL);
+
+        GST_INFO_OBJECT (self, "caps are: %" GST_PTR_FORMAT, caps);
+        gst_pad_set_caps (omx_base->srcpad, caps);
+        gst_buffer_set_caps (buf, caps);
+        gst_caps_unref (caps);
+    }
+
+    if (!GST_BUFFER_DURATION_IS_VALID (buf))
+        GST_BUFFER_DURATION (buf) = get_frame_duration (self);
+}
+
+static gboolean
+src_query (GstPad *pad,
+           GstQuery *query)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (GST_OBJECT_PARENT (pad));
+
+    switch (GST_QUERY_TYPE (query))
+    {
+        case GST_QUERY_LATENCY:
+            {
+                gboolean live;
+                GstClockTime min;
+                GstClockTime max;
+                GstClockTime duration;
+
+                if (!gst_pad_peer_query (GST_OMX_BASE_FILTER (self)->sinkpad, query))
+                    return FALSE;
+
+                gst_query_parse_latency (query, &live, &min, &max);
+
+                /* the component holds at least one frame */
+                duration = get_frame_duration (self);
+                if (GST_CLOCK_TIME_IS_VALID (duration))
+                {
+                    min += duration;
+                    if (GST_CLOCK_TIME_IS_VALID (max))
+                        max += duration;
+                }
+
+                GST_DEBUG_OBJECT (self, "latency: min=%" GST_TIME_FORMAT ", max=%" GST_TIME_FORMAT,
+                                  GST_TIME_ARGS (min), GST_TIME_ARGS (max));
+
+                gst_query_set_latency (query, live, min, max);
+                return TRUE;
+            }
+        default:
+            return gst_pad_query_default (pad, query);
+    }
+}
+
+/* Called from the component thread. */
+static gboolean
+stream_error_cb (GOmxCore *core,
+                 OMX_ERRORTYPE error)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (core->object);
+
+    if (error == OMX_ErrorMbErrorsInFrame)
+        g_atomic_int_inc (&self->concealed_frames);
+    else
+        g_atomic_int_inc (&self->corrupt_frames);
+
+    switch (self->error_policy)
+    {
+        case ERROR_FAIL:
+            return FALSE;
+        case ERROR_DROP_UNTIL_KEYFRAME:
+            g_atomic_int_set (&self->wait_keyframe, TRUE);
+            break;
+        default:
+            break;
+    }
+
+    return TRUE;
+}
+
 static void
 omx_setup (GstOmxBaseFilter *omx_base)
 {
@@ -230,6 +1038,17 @@ omx_setup (GstOmxBaseFilter *omx_base)
 
     GST_INFO_OBJECT (omx_base, "begin");
 
+    g_atomic_int_set (&self->concealed_frames, 0);
+    g_atomic_int_set (&self->corrupt_frames, 0);
+    g_atomic_int_set (&self->wait_keyframe, FALSE);
+
+    GST_OBJECT_LOCK (self);
+    self->estimated_num = 0;
+    self->estimated_denom = 1;
+    GST_OBJECT_UNLOCK (self);
+    g_atomic_int_set (&self->framerate_changed, FALSE);
+    timing_reset (self);
+
     {
         OMX_PARAM_PORTDEFINITIONTYPE param;
 
@@ -252,19 +1071,523 @@ omx_setup (GstOmxBaseFilter *omx_base)
     GST_INFO_OBJECT (omx_base, "end");
 }
 
+/*
+ * Input framing
+ */
+
+static inline gboolean
+framing_supported (GstOmxBaseVideoDec *self)
+{
+    switch (self->compression_format)
+    {
+        case OMX_VIDEO_CodingMPEG4:
+        case OMX_VIDEO_CodingH263:
+        case OMX_VIDEO_CodingAVC:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+/* Whether each buffer submitted holds exactly one frame. */
+static inline gboolean
+input_is_frames (GstOmxBaseVideoDec *self)
+{
+    return GST_OMX_BASE_FILTER (self)->frame_aligned_input || self->aligned_input;
+}
+
+/* Looks at the unit after a start code; tells whether it's picture data,
+ * and whether it opens a new access unit once a picture was seen. */
+static inline gboolean
+classify_unit (GstOmxBaseVideoDec *self,
+               const guint8 *data,
+               gboolean *picture)
+{
+    switch (self->compression_format)
+    {
+        case OMX_VIDEO_CodingMPEG4:
+            /* VOP; headers before it belong to the next frame */
+            *picture = (data[0] == 0xb6);
+            return data[0] != 0xb2; /* user data */
+        case OMX_VIDEO_CodingH263:
+            /* every match is a picture start code */
+            *picture = TRUE;
+            return TRUE;
+        case OMX_VIDEO_CodingAVC:
+            {
+                guint nal_type;
+
+                nal_type = data[0] & 0x1f;
+                *picture = (nal_type >= 1 && nal_type <= 5);
+
+                /* a slice with first_mb_in_slice = 0 */
+                if (*picture)
+                    return (data[1] & 0x80) != 0;
+
+                /* SEI, SPS, PPS, AUD, and 14..18 */
+                return (nal_type >= 6 && nal_type <= 9) ||
+                    (nal_type >= 14 && nal_type <= 18);
+            }
+        default:
+            *picture = FALSE;
+            return FALSE;
+    }
+}
+
+/* Picture type of the first picture unit found; FALSE when unknown. */
+static gboolean
+inspect_picture (GstOmxBaseVideoDec *self,
+                 const guint8 *data,
+                 guint size,
+                 gboolean *keyframe,
+                 gboolean *reference)
+{
+    guint offset = 0;
+
+    *reference = TRUE;
+
+    /* packetized H.264, 4-byte lengths */
+    if (GST_OMX_BASE_FILTER (self)->in_copy)
+    {
+        while (offset + 5 <= size)
+        {
+            guint nal_size;
+            guint nal_type;
+
+            nal_size = GST_READ_UINT32_BE (data + offset);
+            nal_type = data[offset + 4] & 0x1f;
+
+            if (nal_type >= 1 && nal_type <= 5)
+            {
+                *keyframe = (nal_type == 5);
+                *reference = (data[offset + 4] & 0x60) != 0;
+                return TRUE;
+            }
+
+            if (nal_size > size - offset - 4)
+                break;
+
+            offset += 4 + nal_size;
+        }
+
+        return FALSE;
+    }
+
+    while (TRUE)
+    {
+        const guint8 *unit;
+
+        if (self->compression_format == OMX_VIDEO_CodingH263)
+            offset += g_omx_bitstream_find_start_code (data + offset, size - offset, 0xfc, 0x80);
+        else
+            offset += g_omx_bitstream_find_start_code (data + offset, size - offset, 0xff, 0x01);
+
+        if (offset + 5 > size)
+            return FALSE;
+
+        unit = data + offset + 3;
+
+        switch (self->compression_format)
+        {
+            case OMX_VIDEO_CodingMPEG4:
+                if (unit[0] == 0xb6)
+                {
+                    /* vop_coding_type: I, P, B, S */
+                    *keyframe = (unit[1] >> 6) == 0;
+                    *reference = (unit[1] >> 6) != 2;
+                    return TRUE;
+                }
+                break;
+            case OMX_VIDEO_CodingH263:
+                /* source format 7 is PLUSPTYPE, not handled */
+                if (((unit[1] >> 2) & 0x07) == 0x07)
+                    return FALSE;
+                *keyframe = ((unit[1] >> 1) & 0x01) == 0;
+                return TRUE;
+            case OMX_VIDEO_CodingAVC:
+                if ((unit[0] & 0x1f) >= 1 && (unit[0] & 0x1f) <= 5)
+                {
+                    *keyframe = (unit[0] & 0x1f) == 5;
+                    *reference = (unit[0] & 0x60) != 0;
+                    return TRUE;
+                }
+                break;
+            default:
+                return FALSE;
+        }
+
+        offset += 3;
+    }
+}
+
+static GstFlowReturn
+submit_frame (GstOmxBaseVideoDec *self,
+              GstPad *pad,
+              GstBuffer *buf)
+{
+    gint skip_frames;
+
+    {
+        GstClockTime duration;
+
+        duration = get_frame_duration (self);
+
+        if (!GST_BUFFER_TIMESTAMP_IS_VALID (buf) && GST_CLOCK_TIME_IS_VALID (duration))
+        {
+            if (!GST_CLOCK_TIME_IS_VALID (self->next_interpolated))
+                self->next_interpolated = GST_CLOCK_TIME_IS_VALID (self->segment_start) ?
+                    self->segment_start : 0;
+
+            buf = gst_buffer_make_metadata_writable (buf);
+            GST_BUFFER_TIMESTAMP (buf) = self->next_interpolated;
+            GST_LOG_OBJECT (self, "interpolated timestamp: %" GST_TIME_FORMAT,
+                            GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
+        }
+        else if (GST_BUFFER_TIMESTAMP_IS_VALID (buf))
+        {
+            update_framerate (self, GST_BUFFER_TIMESTAMP (buf));
+            duration = get_frame_duration (self);
+        }
+
+        if (GST_BUFFER_TIMESTAMP_IS_VALID (buf) && GST_CLOCK_TIME_IS_VALID (duration))
+            self->next_interpolated = GST_BUFFER_TIMESTAMP (buf) + duration;
+    }
+
+    skip_frames = self->skip_frames;
+
+    /* dropping a buffer with parts of two frames would corrupt both */
+    if (skip_frames != SKIP_NONE && !input_is_frames (self))
+    {
+        if (!self->skip_unaligned)
+            GST_WARNING_OBJECT (self, "input isn't split in frames; not skipping any");
+        self->skip_unaligned = TRUE;
+        skip_frames = SKIP_NONE;
+    }
+
+    /* same for dropping up to a keyframe; pass the frames as they are */
+    if (g_atomic_int_get (&self->wait_keyframe) && !input_is_frames (self))
+    {
+        GST_WARNING_OBJECT (self, "input isn't split in frames; not waiting for a keyframe");
+        g_atomic_int_set (&self->wait_keyframe, FALSE);
+    }
+
+    if (skip_frames != SKIP_NONE || g_atomic_int_get (&self->wait_keyframe))
+    {
+        gboolean keyframe;
+        gboolean reference;
+
+        /* framed buffers have no flags, trust the bitstream first */
+        if (!inspect_picture (self, GST_BUFFER_DATA (buf), GST_BUFFER_SIZE (buf),
+                              &keyframe, &reference))
+        {
+            keyframe = !GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+            reference = TRUE;
+        }
+
+        if ((skip_frames == SKIP_NON_KEYFRAME && !keyframe) ||
+            (skip_frames == SKIP_NON_REFERENCE && !reference))
+        {
+            GST_LOG_OBJECT (self, "skipping frame: timestamp=%" GST_TIME_FORMAT,
+                            GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
+            gst_buffer_unref (buf);
+            return GST_FLOW_OK;
+        }
+
+        /* after a stream error, references may be broken */
+        if (g_atomic_int_get (&self->wait_keyframe))
+        {
+            if (!keyframe)
+            {
+                GST_LOG_OBJECT (self, "waiting for keyframe: timestamp=%" GST_TIME_FORMAT,
+                                GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
+                gst_buffer_unref (buf);
+                return GST_FLOW_OK;
+            }
+            g_atomic_int_set (&self->wait_keyframe, FALSE);
+        }
+    }
+
+    /* pre-roll after an accurate seek; only needed as reference */
+    {
+        GstClockTime end;
+
+        end = GST_BUFFER_TIMESTAMP (buf);
+        if (GST_CLOCK_TIME_IS_VALID (end) && GST_BUFFER_DURATION_IS_VALID (buf))
+            end += GST_BUFFER_DURATION (buf);
+
+        GST_OMX_BASE_FILTER (self)->decode_only =
+            GST_CLOCK_TIME_IS_VALID (end) &&
+            GST_CLOCK_TIME_IS_VALID (self->segment_start) &&
+            end <= self->segment_start &&
+            GST_BUFFER_TIMESTAMP (buf) < self->segment_start;
+    }
+
+    return self->base_chain (pad, buf);
+}
+
+static GstFlowReturn
+push_frame (GstOmxBaseVideoDec *self,
+            GstPad *pad,
+            guint size)
+{
+    GstBuffer *buf;
+    gboolean keyframe;
+    gboolean reference;
+
+    buf = gst_adapter_take_buffer (self->adapter, size);
+    GST_BUFFER_TIMESTAMP (buf) = self->frame_timestamp;
+
+    /* the upstream flags are lost in the adapter */
+    if (inspect_picture (self, GST_BUFFER_DATA (buf), size, &keyframe, &reference) &&
+        !keyframe)
+        GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+    GST_LOG_OBJECT (self, "frame: size=%u, timestamp=%" GST_TIME_FORMAT,
+                    size, GST_TIME_ARGS (self->frame_timestamp));
+
+    return submit_frame (self, pad, buf);
+}
+
+static GstFlowReturn
+pad_chain (GstPad *pad,
+           GstBuffer *buf)
+{
+    GstOmxBaseVideoDec *self;
+    GstOmxBaseFilter *omx_base;
+    GstFlowReturn ret = GST_FLOW_OK;
+    const guint8 *data;
+    guint8 mask;
+    guint8 value;
+    gint buf_start;
+
+    self = GST_OMX_BASE_VIDEODEC (GST_OBJECT_PARENT (pad));
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    if (!self->framing)
+    {
+        omx_base->frame_aligned_input = FALSE;
+        return submit_frame (self, pad, buf);
+    }
+
+    /* packetized input (converted on the way in) is already aligned too;
+     * gathering it again would only hold every frame back */
+    if (self->aligned_input || omx_base->in_copy)
+    {
+        omx_base->frame_aligned_input = TRUE;
+        return submit_frame (self, pad, buf);
+    }
+
+    if (!framing_supported (self))
+    {
+        omx_base->frame_aligned_input = FALSE;
+        return submit_frame (self, pad, buf);
+    }
+
+    omx_base->frame_aligned_input = TRUE;
+
+    /* the byte after the two zeros of the start code */
+    if (self->compression_format == OMX_VIDEO_CodingH263)
+    {
+        mask = 0xfc;
+        value = 0x80;
+    }
+    else
+    {
+        mask = 0xff;
+        value = 0x01;
+    }
+
+    buf_start = gst_adapter_available (self->adapter);
+    if (buf_start == 0)
+    {
+        self->frame_timestamp = GST_BUFFER_TIMESTAMP (buf);
+        self->next_timestamp = GST_CLOCK_TIME_NONE;
+    }
+    else
+    {
+        self->next_timestamp = GST_BUFFER_TIMESTAMP (buf);
+    }
+
+    gst_adapter_push (self->adapter, buf);
+
+    data = NULL;
+
+    while (TRUE)
+    {
+        guint avail;
+        guint offset;
+        gboolean picture;
+
+        avail = gst_adapter_available (self->adapter);
+
+        /* the prefix plus two bytes of the unit are needed */
+        if (self->scan_offset + 5 > avail)
+            break;
+
+        /* peeked once per input buffer and once per frame cut; only what
+         * wasn't scanned yet is searched */
+        if (!data)
+            data = gst_adapter_peek (self->adapter, avail);
+
+        offset = self->scan_offset +
+            g_omx_bitstream_find_start_code (data + self->scan_offset,
+                                             avail - 2 - self->scan_offset,
+                                             mask, value);
+
+        if (offset + 5 > avail)
+        {
+            /* a start code may be split with the next buffer */
+            self->scan_offset = avail - 4;
+            break;
+        }
+
+        if (classify_unit (self, data + offset + 3, &picture) &&
+            self->picture_seen && offset > 0)
+        {
+            guint cut;
+
+            cut = offset;
+
+            /* 4-byte start codes belong to the next unit */
+            if (self->compression_format == OMX_VIDEO_CodingAVC &&
+                data[cut - 1] == 0)
+                cut--;
+
+            ret = push_frame (self, pad, cut);
+            data = NULL;
+
+            self->scan_offset = offset - cut;
+            self->picture_seen = FALSE;
+
+            /* only the first frame starting in a buffer gets its timestamp */
+            if ((gint) cut >= buf_start)
+            {
+                self->frame_timestamp = self->next_timestamp;
+                self->next_timestamp = GST_CLOCK_TIME_NONE;
+            }
+            else
+            {
+                self->frame_timestamp = GST_CLOCK_TIME_NONE;
+            }
+            buf_start -= cut;
+
+            if (ret != GST_FLOW_OK)
+                break;
+
+            /* look at the same start code again, now in its own frame */
+            continue;
+        }
+
+        if (picture)
+            self->picture_seen = TRUE;
+
+        self->scan_offset = offset + 3;
+    }
+
+    return ret;
+}
+
+static void
+framing_reset (GstOmxBaseVideoDec *self)
+{
+    gst_adapter_clear (self->adapter);
+    self->scan_offset = 0;
+    self->picture_seen = FALSE;
+    self->frame_timestamp = GST_CLOCK_TIME_NONE;
+    self->next_timestamp = GST_CLOCK_TIME_NONE;
+}
+
+static gboolean
+sink_event (GstPad *pad,
+            GstEvent *event)
+{
+    GstOmxBaseVideoDec *self;
+    guint avail;
+
+    self = GST_OMX_BASE_VIDEODEC (GST_OBJECT_PARENT (pad));
+
+    switch (GST_EVENT_TYPE (event))
+    {
+        case GST_EVENT_EOS:
+            /* the last frame has no start code after it */
+            avail = gst_adapter_available (self->adapter);
+            if (avail > 0)
+            {
+                GstFlowReturn ret;
+
+                ret = push_frame (self, pad, avail);
+                if (ret != GST_FLOW_OK)
+                    GST_WARNING_OBJECT (self, "last frame not decoded: %s",
+                                        gst_flow_get_name (ret));
+            }
+            framing_reset (self);
+            break;
+        case GST_EVENT_FLUSH_STOP:
+            framing_reset (self);
+            timing_reset (self);
+            break;
+        case GST_EVENT_NEWSEGMENT:
+            {
+                gboolean update;
+                gdouble rate;
+                GstFormat format;
+                gint64 start;
+                gint64 stop;
+                gint64 position;
+
+                gst_event_parse_new_segment (event, &update, &rate, &format,
+                                             &start, &stop, &position);
+
+                if (format == GST_FORMAT_TIME && rate > 0.0 && start >= 0)
+                    self->segment_start = start;
+                else
+                    self->segment_start = GST_CLOCK_TIME_NONE;
+
+                GST_DEBUG_OBJECT (self, "segment start: %" GST_TIME_FORMAT,
+                                  GST_TIME_ARGS (self->segment_start));
+                break;
+            }
+        default:
+            break;
+    }
+
+    return self->base_sink_event (pad, event);
+}
+
 static void
 type_instance_init (GTypeInstance *instance,
                     gpointer g_class)
 {
     GstOmxBaseFilter *omx_base;
+    GstOmxBaseVideoDec *self;
 
     omx_base = GST_OMX_BASE_FILTER (instance);
+    self = GST_OMX_BASE_VIDEODEC (instance);
 
     omx_base->omx_setup = omx_setup;
+    omx_base->prepare_output = prepare_output;
+    omx_base->in_sync_flags = TRUE;
 
     omx_base->gomx->settings_changed_cb = settings_changed_cb;
+    omx_base->gomx->stream_error_cb = stream_error_cb;
 
     gst_pad_set_setcaps_function (omx_base->sinkpad, sink_setcaps);
+
+    self->base_chain = GST_PAD_CHAINFUNC (omx_base->sinkpad);
+    gst_pad_set_chain_function (omx_base->sinkpad, pad_chain);
+
+    self->base_sink_event = GST_PAD_EVENTFUNC (omx_base->sinkpad);
+    gst_pad_set_event_function (omx_base->sinkpad, sink_event);
+
+    gst_pad_set_query_function (omx_base->srcpad, src_query);
+
+    self->framing = DEFAULT_FRAMING;
+    self->skip_frames = DEFAULT_SKIP_FRAMES;
+    self->error_policy = DEFAULT_ERROR_POLICY;
+    self->segment_start = GST_CLOCK_TIME_NONE;
+    self->adapter = gst_adapter_new ();
+    framing_reset (self);
+    timing_reset (self);
 }
 
 GType
@@ -32,8 +32,10 @@ G_BEGIN_DECLS
 
 typedef struct GstOmxBaseVideoDec GstOmxBaseVideoDec;
 typedef struct GstOmxBaseVideoDecClass GstOmxBaseVideoDecClass;
+typedef struct GstOmxVideoName GstOmxVideoName;
 
 #include "gstomx_base_filter.h"
+#include <gst/base/gstadapter.h>
 
 struct GstOmxBaseVideoDec
 {
@@ -42,6 +44,42 @@ struct GstOmxBaseVideoDec
     OMX_VIDEO_CODINGTYPE compression_format;
     gint framerate_num;
     gint framerate_denom;
+
+    /* Output geometry, needed when converting NV12 to I420. */
+    guint width;
+    guint height;
+    guint stride;
+    guint slice_height;
+    gboolean convert_nv12;
+
+    /* Input framing, one access unit per OpenMAX buffer. */
+    gboolean framing;
+    gboolean aligned_input; /**< Upstream buffers are whole access units */
+    GstAdapter *adapter;
+    guint scan_offset; /**< Where to resume looking for start codes */
+    gboolean picture_seen; /**< Current access unit has picture data */
+    GstClockTime frame_timestamp; /**< Of the access unit being gathered */
+    GstClockTime next_timestamp; /**< Of the last input, if not used yet */
+    GstPadChainFunction base_chain;
+    GstPadEventFunction base_sink_event;
+
+    gint skip_frames;
+    gboolean skip_unaligned; /**< Warned that skipping needs whole frames */
+    GstClockTime segment_start;
+
+    /* Framerate estimate, for streams whose caps have none. */
+    GstClockTime timestamps[32]; /**< Last input timestamps, decode order */
+    guint timestamp_count;
+    gint estimated_num;
+    gint estimated_denom;
+    gint framerate_changed; /**< Src caps lack the current estimate */
+    GstClockTime next_interpolated; /**< For input without a timestamp */
+
+    /* Stream errors the component recovered from. */
+    gint error_policy;
+    gint concealed_frames;
+    gint corrupt_frames;
+    gint wait_keyframe; /**< Drop input until the next keyframe */
 };
 
 struct GstOmxBaseVideoDecClass
@@ -49,8 +87,20 @@ struct GstOmxBaseVideoDecClass
     GstOmxBaseFilterClass parent_class;
 };
 
+/* Caps name of an OpenMAX profile or level; tables end with a NULL name. */
+struct GstOmxVideoName
+{
+    guint omx_value;
+    const gchar *name;
+};
+
 GType gst_omx_base_videodec_get_type (void);
 
+GstCaps *gst_omx_base_videodec_probe_sink_caps (gpointer g_class,
+                                                GstCaps *caps,
+                                                const GstOmxVideoName *profiles,
+                                                const GstOmxVideoName *levels);
+
 G_END_DECLS
 
 #endif /* GSTOMX_BASE_VIDEODEC_H */
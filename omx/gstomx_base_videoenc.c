@@ -28,12 +28,95 @@ enum
 {
     ARG_0,
     ARG_BITRATE,
+    ARG_CONTROL_RATE,
+    ARG_P_FRAMES,
+    ARG_B_FRAMES,
+    ARG_QUANT_I,
+    ARG_QUANT_P,
+    ARG_QUANT_B,
+    ARG_LOW_LATENCY,
+    ARG_OUTPUT_MODE,
+    ARG_PROFILE,
+    ARG_LEVEL,
+};
+
+enum
+{
+    OUTPUT_MODE_PASSTHROUGH,
+    OUTPUT_MODE_ACCESS_UNIT,
 };
 
 #define DEFAULT_BITRATE 500000
+#define DEFAULT_CONTROL_RATE -1
+#define DEFAULT_P_FRAMES -1
+#define DEFAULT_B_FRAMES -1
+#define DEFAULT_QUANT -1
+#define DEFAULT_LOW_LATENCY FALSE
+#define DEFAULT_OUTPUT_MODE OUTPUT_MODE_PASSTHROUGH
 
 static GstOmxBaseFilterClass *parent_class;
 
+#define GST_TYPE_OMX_VIDEOENC_CONTROL_RATE (gst_omx_videoenc_control_rate_get_type ())
+static GType
+gst_omx_videoenc_control_rate_get_type (void)
+{
+    static GType gst_omx_videoenc_control_rate_type = 0;
+
+    if (!gst_omx_videoenc_control_rate_type) {
+        static GEnumValue gst_omx_videoenc_control_rate[] = {
+            {-1, "Component default", "default"},
+            {OMX_Video_ControlRateDisable, "Disable (constant quantizer)", "disable"},
+            {OMX_Video_ControlRateVariable, "Variable bit-rate", "variable"},
+            {OMX_Video_ControlRateConstant, "Constant bit-rate", "constant"},
+            {OMX_Video_ControlRateVariableSkipFrames, "Variable bit-rate, skipping frames", "variable-skip-frames"},
+            {OMX_Video_ControlRateConstantSkipFrames, "Constant bit-rate, skipping frames", "constant-skip-frames"},
+            {0, NULL, NULL},
+        };
+
+        gst_omx_videoenc_control_rate_type = g_enum_register_static ("GstOmxVideoEncControlRate",
+                                                                     gst_omx_videoenc_control_rate);
+    }
+
+    return gst_omx_videoenc_control_rate_type;
+}
+
+#define GST_TYPE_OMX_VIDEOENC_OUTPUT_MODE (gst_omx_videoenc_output_mode_get_type ())
+static GType
+gst_omx_videoenc_output_mode_get_type (void)
+{
+    static GType gst_omx_videoenc_output_mode_type = 0;
+
+    if (!gst_omx_videoenc_output_mode_type) {
+        static GEnumValue gst_omx_videoenc_output_mode[] = {
+            {OUTPUT_MODE_PASSTHROUGH, "Push buffers as the component returns them", "passthrough"},
+            {OUTPUT_MODE_ACCESS_UNIT, "Push one buffer per access unit", "access-unit"},
+            {0, NULL, NULL},
+        };
+
+        gst_omx_videoenc_output_mode_type = g_enum_register_static ("GstOmxVideoEncOutputMode",
+                                                                    gst_omx_videoenc_output_mode);
+    }
+
+    return gst_omx_videoenc_output_mode_type;
+}
+
+static void
+clear_fragments (GstOmxBaseVideoEnc *self)
+{
+    g_slist_foreach (self->fragments, (GFunc) gst_mini_object_unref, NULL);
+    g_slist_free (self->fragments);
+    self->fragments = NULL;
+    self->fragments_size = 0;
+}
+
+static void
+finalize (GObject *obj)
+{
+    clear_fragments (GST_OMX_BASE_VIDEOENC (obj));
+
+    G_OBJECT_CLASS (parent_class)->finalize (obj);
+}
+
 static GstCaps *
 generate_sink_template (void)
 {
@@ -108,7 +191,40 @@ set_property (GObject *obj,
     switch (prop_id)
     {
         case ARG_BITRATE:
+            GST_OBJECT_LOCK (self);
             self->bitrate = g_value_get_uint (value);
+            self->bitrate_changed = TRUE;
+            GST_OBJECT_UNLOCK (self);
+            break;
+        case ARG_CONTROL_RATE:
+            self->control_rate = g_value_get_enum (value);
+            break;
+        case ARG_P_FRAMES:
+            self->p_frames = g_value_get_int (value);
+            break;
+        case ARG_B_FRAMES:
+            self->b_frames = g_value_get_int (value);
+            break;
+        case ARG_QUANT_I:
+            self->quant_i = g_value_get_int (value);
+            break;
+        case ARG_QUANT_P:
+            self->quant_p = g_value_get_int (value);
+            break;
+        case ARG_QUANT_B:
+            self->quant_b = g_value_get_int (value);
+            break;
+        case ARG_LOW_LATENCY:
+            self->low_latency = g_value_get_boolean (value);
+            break;
+        case ARG_OUTPUT_MODE:
+            self->output_mode = g_value_get_enum (value);
+            break;
+        case ARG_PROFILE:
+            self->profile = g_value_get_enum (value);
+            break;
+        case ARG_LEVEL:
+            self->level = g_value_get_enum (value);
             break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
@@ -129,9 +245,38 @@ get_property (GObject *obj,
     switch (prop_id)
     {
         case ARG_BITRATE:
-            /** @todo propagate this to OpenMAX when processing. */
             g_value_set_uint (value, self->bitrate);
             break;
+        case ARG_CONTROL_RATE:
+            g_value_set_enum (value, self->control_rate);
+            break;
+        case ARG_P_FRAMES:
+            g_value_set_int (value, self->p_frames);
+            break;
+        case ARG_B_FRAMES:
+            g_value_set_int (value, self->b_frames);
+            break;
+        case ARG_QUANT_I:
+            g_value_set_int (value, self->quant_i);
+            break;
+        case ARG_QUANT_P:
+            g_value_set_int (value, self->quant_p);
+            break;
+        case ARG_QUANT_B:
+            g_value_set_int (value, self->quant_b);
+            break;
+        case ARG_LOW_LATENCY:
+            g_value_set_boolean (value, self->low_latency);
+            break;
+        case ARG_OUTPUT_MODE:
+            g_value_set_enum (value, self->output_mode);
+            break;
+        case ARG_PROFILE:
+            g_value_set_enum (value, self->profile);
+            break;
+        case ARG_LEVEL:
+            g_value_set_enum (value, self->level);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -148,6 +293,8 @@ type_class_init (gpointer g_class,
 
     parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
 
+    gobject_class->finalize = finalize;
+
     /* Properties stuff */
     {
         gobject_class->set_property = set_property;
@@ -155,11 +302,88 @@ type_class_init (gpointer g_class,
 
         g_object_class_install_property (gobject_class, ARG_BITRATE,
                                          g_param_spec_uint ("bitrate", "Bit-rate",
-                                                            "Encoding bit-rate",
+                                                            "Encoding bit-rate (can be changed while playing)",
                                                             0, G_MAXUINT, DEFAULT_BITRATE, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_CONTROL_RATE,
+                                         g_param_spec_enum ("control-rate", "Control rate",
+                                                            "OMX_VIDEO_CONTROLRATETYPE of output",
+                                                            GST_TYPE_OMX_VIDEOENC_CONTROL_RATE,
+                                                            DEFAULT_CONTROL_RATE,
+                                                            G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_P_FRAMES,
+                                         g_param_spec_int ("p-frames", "P-frames",
+                                                           "Number of P frames between I frames (-1 = component default)",
+                                                           -1, G_MAXINT, DEFAULT_P_FRAMES, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_B_FRAMES,
+                                         g_param_spec_int ("b-frames", "B-frames",
+                                                           "Number of B frames between I or P frames (-1 = component default)",
+                                                           -1, G_MAXINT, DEFAULT_B_FRAMES, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_QUANT_I,
+                                         g_param_spec_int ("quant-i", "I quantizer",
+                                                           "Quantization parameter for I frames (-1 = component default)",
+                                                           -1, G_MAXINT, DEFAULT_QUANT, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_QUANT_P,
+                                         g_param_spec_int ("quant-p", "P quantizer",
+                                                           "Quantization parameter for P frames (-1 = component default)",
+                                                           -1, G_MAXINT, DEFAULT_QUANT, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_QUANT_B,
+                                         g_param_spec_int ("quant-b", "B quantizer",
+                                                           "Quantization parameter for B frames (-1 = component default)",
+                                                           -1, G_MAXINT, DEFAULT_QUANT, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_LOW_LATENCY,
+                                         g_param_spec_boolean ("low-latency", "Low latency",
+                                                               "Disable B frames and push every slice as soon as it's encoded",
+                                                               DEFAULT_LOW_LATENCY, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_OUTPUT_MODE,
+                                         g_param_spec_enum ("output-mode", "Output mode",
+                                                            "Whether to gather slices and NAL units in access units (ignored in low-latency mode)",
+                                                            GST_TYPE_OMX_VIDEOENC_OUTPUT_MODE,
+                                                            DEFAULT_OUTPUT_MODE,
+                                                            G_PARAM_READWRITE));
     }
 }
 
+/* For the class_init of each codec; the tables start with the component
+ * default, 0, and must be static. */
+void
+gst_omx_base_videoenc_class_add_profiles (GstOmxBaseVideoEncClass *klass,
+                                          const GEnumValue *profiles,
+                                          const GEnumValue *levels)
+{
+    GObjectClass *gobject_class;
+    gchar *name;
+
+    gobject_class = G_OBJECT_CLASS (klass);
+
+    name = g_strconcat (G_OBJECT_CLASS_NAME (klass), "Profile", NULL);
+    klass->profile_type = g_enum_register_static (name, profiles);
+    g_free (name);
+
+    name = g_strconcat (G_OBJECT_CLASS_NAME (klass), "Level", NULL);
+    klass->level_type = g_enum_register_static (name, levels);
+    g_free (name);
+
+    g_object_class_install_property (gobject_class, ARG_PROFILE,
+                                     g_param_spec_enum ("profile", "Profile",
+                                                        "Encoding profile",
+                                                        klass->profile_type,
+                                                        0, G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class, ARG_LEVEL,
+                                     g_param_spec_enum ("level", "Level",
+                                                        "Maximum encoding level",
+                                                        klass->level_type,
+                                                        0, G_PARAM_READWRITE));
+}
+
 static gboolean
 sink_setcaps (GstPad *pad,
               GstCaps *caps)
@@ -244,11 +468,208 @@ sink_setcaps (GstPad *pad,
     return gst_pad_set_caps (pad, caps);
 }
 
+/* Check against what the component claims to support; components
+ * that can't be queried are trusted. */
+static gboolean
+profile_level_supported (GstOmxBaseVideoEnc *self,
+                         guint profile,
+                         guint level)
+{
+    GOmxCore *gomx;
+    OMX_VIDEO_PARAM_PROFILELEVELTYPE param;
+    gboolean queried = FALSE;
+    guint i;
+
+    gomx = GST_OMX_BASE_FILTER (self)->gomx;
+
+    memset (&param, 0, sizeof (param));
+    param.nSize = sizeof (OMX_VIDEO_PARAM_PROFILELEVELTYPE);
+    param.nVersion.s.nVersionMajor = 1;
+    param.nVersion.s.nVersionMinor = 1;
+
+    param.nPortIndex = 1;
+
+    for (i = 0; i < 64; i++)
+    {
+        param.nProfileIndex = i;
+        if (OMX_GetParameter (gomx->omx_handle, OMX_IndexParamVideoProfileLevelQuerySupported, &param) != OMX_ErrorNone)
+            break;
+
+        queried = TRUE;
+
+        GST_DEBUG_OBJECT (self, "supported: profile=0x%lx, level=0x%lx",
+                          param.eProfile, param.eLevel);
+
+        /* levels are ordered, the maximum one is reported */
+        if (param.eProfile == profile && param.eLevel >= level)
+            return TRUE;
+    }
+
+    return !queried;
+}
+
+static inline void
+setup_profile_level (GstOmxBaseVideoEnc *self,
+                     OMX_U32 *profile,
+                     OMX_U32 *level)
+{
+    guint new_profile;
+    guint new_level;
+
+    if (!self->profile && !self->level)
+        return;
+
+    new_profile = self->profile ? self->profile : *profile;
+    new_level = self->level ? self->level : *level;
+
+    if (!profile_level_supported (self, new_profile, new_level))
+    {
+        GST_WARNING_OBJECT (self, "profile 0x%x, level 0x%x not supported; using defaults",
+                            new_profile, new_level);
+        return;
+    }
+
+    *profile = new_profile;
+    *level = new_level;
+}
+
+static inline void
+setup_gop (GstOmxBaseVideoEnc *self,
+           OMX_U32 *p_frames,
+           OMX_U32 *b_frames,
+           OMX_U32 *allowed_picture_types)
+{
+    gint b;
+
+    if (self->p_frames >= 0)
+        *p_frames = self->p_frames;
+
+    /* B frames need future input, no way to have them with low latency */
+    b = self->low_latency ? 0 : self->b_frames;
+
+    if (b >= 0)
+    {
+        *b_frames = b;
+        if (b == 0)
+            *allowed_picture_types &= ~OMX_VIDEO_PictureTypeB;
+        else
+            *allowed_picture_types |= OMX_VIDEO_PictureTypeB;
+    }
+}
+
+/* One slice per macroblock row, unless the component already slices. */
+static inline void
+setup_slices (GstOmxBaseVideoEnc *self,
+              OMX_U32 *slice_header_spacing,
+              guint width)
+{
+    if (!self->low_latency || *slice_header_spacing)
+        return;
+
+    if (width == 0)
+    {
+        GST_WARNING_OBJECT (self, "unknown width; output will be whole frames");
+        return;
+    }
+
+    *slice_header_spacing = (width + 15) / 16;
+}
+
+static void
+setup_codec (GstOmxBaseVideoEnc *self,
+             guint width)
+{
+    GOmxCore *gomx;
+
+    gomx = GST_OMX_BASE_FILTER (self)->gomx;
+
+    switch (self->compression_format)
+    {
+        case OMX_VIDEO_CodingAVC:
+            {
+                OMX_VIDEO_PARAM_AVCTYPE param;
+
+                memset (&param, 0, sizeof (param));
+                param.nSize = sizeof (OMX_VIDEO_PARAM_AVCTYPE);
+                param.nVersion.s.nVersionMajor = 1;
+                param.nVersion.s.nVersionMinor = 1;
+
+                param.nPortIndex = 1;
+                OMX_GetParameter (gomx->omx_handle, OMX_IndexParamVideoAvc, &param);
+
+                setup_gop (self, &param.nPFrames, &param.nBFrames, &param.nAllowedPictureTypes);
+                setup_profile_level (self, (OMX_U32 *) &param.eProfile, (OMX_U32 *) &param.eLevel);
+                setup_slices (self, &param.nSliceHeaderSpacing, width);
+
+                OMX_SetParameter (gomx->omx_handle, OMX_IndexParamVideoAvc, &param);
+
+                if (self->low_latency)
+                {
+                    OMX_VIDEO_PARAM_AVCSLICEFMO fmo;
+
+                    memset (&fmo, 0, sizeof (fmo));
+                    fmo.nSize = sizeof (OMX_VIDEO_PARAM_AVCSLICEFMO);
+                    fmo.nVersion.s.nVersionMajor = 1;
+                    fmo.nVersion.s.nVersionMinor = 1;
+
+                    fmo.nPortIndex = 1;
+                    OMX_GetParameter (gomx->omx_handle, OMX_IndexParamVideoSliceFMO, &fmo);
+
+                    fmo.eSliceMode = OMX_VIDEO_SLICEMODE_AVCMBSlice;
+
+                    if (OMX_SetParameter (gomx->omx_handle, OMX_IndexParamVideoSliceFMO, &fmo) != OMX_ErrorNone)
+                        GST_WARNING_OBJECT (self, "slice mode not supported; output will be whole frames");
+                }
+                break;
+            }
+        case OMX_VIDEO_CodingMPEG4:
+            {
+                OMX_VIDEO_PARAM_MPEG4TYPE param;
+
+                memset (&param, 0, sizeof (param));
+                param.nSize = sizeof (OMX_VIDEO_PARAM_MPEG4TYPE);
+                param.nVersion.s.nVersionMajor = 1;
+                param.nVersion.s.nVersionMinor = 1;
+
+                param.nPortIndex = 1;
+                OMX_GetParameter (gomx->omx_handle, OMX_IndexParamVideoMpeg4, &param);
+
+                setup_gop (self, &param.nPFrames, &param.nBFrames, &param.nAllowedPictureTypes);
+                setup_profile_level (self, (OMX_U32 *) &param.eProfile, (OMX_U32 *) &param.eLevel);
+                setup_slices (self, &param.nSliceHeaderSpacing, width);
+
+                OMX_SetParameter (gomx->omx_handle, OMX_IndexParamVideoMpeg4, &param);
+                break;
+            }
+        case OMX_VIDEO_CodingH263:
+            {
+                OMX_VIDEO_PARAM_H263TYPE param;
+
+                memset (&param, 0, sizeof (param));
+                param.nSize = sizeof (OMX_VIDEO_PARAM_H263TYPE);
+                param.nVersion.s.nVersionMajor = 1;
+                param.nVersion.s.nVersionMinor = 1;
+
+                param.nPortIndex = 1;
+                OMX_GetParameter (gomx->omx_handle, OMX_IndexParamVideoH263, &param);
+
+                setup_gop (self, &param.nPFrames, &param.nBFrames, &param.nAllowedPictureTypes);
+                setup_profile_level (self, (OMX_U32 *) &param.eProfile, (OMX_U32 *) &param.eLevel);
+
+                OMX_SetParameter (gomx->omx_handle, OMX_IndexParamVideoH263, &param);
+                break;
+            }
+        default:
+            break;
+    }
+}
+
 static void
 omx_setup (GstOmxBaseFilter *omx_base)
 {
     GstOmxBaseVideoEnc *self;
     GOmxCore *gomx;
+    guint width;
 
     self = GST_OMX_BASE_VIDEOENC (omx_base);
     gomx = (GOmxCore *) omx_base->gomx;
@@ -270,16 +691,354 @@ omx_setup (GstOmxBaseFilter *omx_base)
 
             param.format.video.eCompressionFormat = self->compression_format;
 
-            /** @todo this should be set with a property */
+            GST_OBJECT_LOCK (self);
             param.format.video.nBitrate = self->bitrate;
+            self->bitrate_changed = FALSE;
+            GST_OBJECT_UNLOCK (self);
 
             OMX_SetParameter (gomx->omx_handle, OMX_IndexParamPortDefinition, &param);
         }
+
+        /* sink_setcaps only sets the size on the input port */
+        {
+            param.nPortIndex = 0;
+            OMX_GetParameter (gomx->omx_handle, OMX_IndexParamPortDefinition, &param);
+
+            width = param.format.video.nFrameWidth;
+        }
     }
 
+    if (self->control_rate != DEFAULT_CONTROL_RATE)
+    {
+        OMX_VIDEO_PARAM_BITRATETYPE param;
+
+        memset (&param, 0, sizeof (param));
+        param.nSize = sizeof (OMX_VIDEO_PARAM_BITRATETYPE);
+        param.nVersion.s.nVersionMajor = 1;
+        param.nVersion.s.nVersionMinor = 1;
+
+        param.nPortIndex = 1;
+        OMX_GetParameter (gomx->omx_handle, OMX_IndexParamVideoBitrate, &param);
+
+        param.eControlRate = self->control_rate;
+        param.nTargetBitrate = self->bitrate;
+
+        OMX_SetParameter (gomx->omx_handle, OMX_IndexParamVideoBitrate, &param);
+    }
+
+    if (self->quant_i >= 0 || self->quant_p >= 0 || self->quant_b >= 0)
+    {
+        OMX_VIDEO_PARAM_QUANTIZATIONTYPE param;
+
+        memset (&param, 0, sizeof (param));
+        param.nSize = sizeof (OMX_VIDEO_PARAM_QUANTIZATIONTYPE);
+        param.nVersion.s.nVersionMajor = 1;
+        param.nVersion.s.nVersionMinor = 1;
+
+        param.nPortIndex = 1;
+        OMX_GetParameter (gomx->omx_handle, OMX_IndexParamVideoQuantization, &param);
+
+        if (self->quant_i >= 0)
+            param.nQpI = self->quant_i;
+        if (self->quant_p >= 0)
+            param.nQpP = self->quant_p;
+        if (self->quant_b >= 0)
+            param.nQpB = self->quant_b;
+
+        OMX_SetParameter (gomx->omx_handle, OMX_IndexParamVideoQuantization, &param);
+    }
+
+    setup_codec (self, width);
+
+    self->in_frame = FALSE;
+    clear_fragments (self);
+
     GST_INFO_OBJECT (omx_base, "end");
 }
 
+static inline gboolean
+is_force_key_unit (GstEvent *event)
+{
+    const GstStructure *structure;
+
+    structure = gst_event_get_structure (event);
+
+    return structure && gst_structure_has_name (structure, "GstForceKeyUnit");
+}
+
+static inline void
+request_keyframe (GstOmxBaseVideoEnc *self)
+{
+    GST_INFO_OBJECT (self, "keyframe requested");
+
+    GST_OBJECT_LOCK (self);
+    self->keyframe_requested = TRUE;
+    GST_OBJECT_UNLOCK (self);
+}
+
+static gboolean
+sink_event (GstPad *pad,
+            GstEvent *event)
+{
+    GstOmxBaseVideoEnc *self;
+
+    self = GST_OMX_BASE_VIDEOENC (GST_OBJECT_PARENT (pad));
+
+    switch (GST_EVENT_TYPE (event))
+    {
+        case GST_EVENT_CUSTOM_DOWNSTREAM:
+            if (is_force_key_unit (event))
+                request_keyframe (self);
+            break;
+
+        case GST_EVENT_FLUSH_STOP:
+            GST_OBJECT_LOCK (self);
+            self->keyframe_requested = FALSE;
+            self->keyframe_pending = FALSE;
+            self->in_frame = FALSE;
+            GST_OBJECT_UNLOCK (self);
+            /* the output task is paused by now */
+            clear_fragments (self);
+            break;
+
+        default:
+            break;
+    }
+
+    return self->base_sink_event (pad, event);
+}
+
+static gboolean
+src_event (GstPad *pad,
+           GstEvent *event)
+{
+    GstOmxBaseVideoEnc *self;
+
+    self = GST_OMX_BASE_VIDEOENC (GST_OBJECT_PARENT (pad));
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CUSTOM_UPSTREAM &&
+        is_force_key_unit (event))
+    {
+        request_keyframe (self);
+    }
+
+    return gst_pad_event_default (pad, event);
+}
+
+static void
+prepare_input (GstOmxBaseFilter *omx_base,
+               GstBuffer *buf)
+{
+    GstOmxBaseVideoEnc *self;
+    GOmxCore *gomx;
+    gboolean bitrate_changed;
+    gboolean keyframe_requested;
+    guint bitrate;
+
+    self = GST_OMX_BASE_VIDEOENC (omx_base);
+    gomx = (GOmxCore *) omx_base->gomx;
+
+    GST_OBJECT_LOCK (self);
+    bitrate_changed = self->bitrate_changed;
+    bitrate = self->bitrate;
+    self->bitrate_changed = FALSE;
+    keyframe_requested = self->keyframe_requested;
+    self->keyframe_requested = FALSE;
+    if (keyframe_requested)
+    {
+        self->keyframe_pending = TRUE;
+        self->keyframe_timestamp = GST_BUFFER_TIMESTAMP (buf);
+    }
+    GST_OBJECT_UNLOCK (self);
+
+    if (keyframe_requested)
+    {
+        OMX_CONFIG_INTRAREFRESHVOPTYPE config;
+        OMX_ERRORTYPE omx_error;
+
+        memset (&config, 0, sizeof (config));
+        config.nSize = sizeof (OMX_CONFIG_INTRAREFRESHVOPTYPE);
+        config.nVersion.s.nVersionMajor = 1;
+        config.nVersion.s.nVersionMinor = 1;
+
+        config.nPortIndex = 1;
+        config.IntraRefreshVOP = OMX_TRUE;
+
+        GST_INFO_OBJECT (self, "forcing keyframe at %" GST_TIME_FORMAT,
+                         GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
+        omx_error = OMX_SetConfig (gomx->omx_handle, OMX_IndexConfigVideoIntraVOPRefresh, &config);
+        if (omx_error != OMX_ErrorNone)
+            GST_WARNING_OBJECT (self, "couldn't force keyframe: 0x%x", omx_error);
+    }
+
+    /* applied between frames; no restart, no forced keyframe */
+    if (bitrate_changed)
+    {
+        OMX_VIDEO_CONFIG_BITRATETYPE config;
+        OMX_ERRORTYPE omx_error;
+
+        memset (&config, 0, sizeof (config));
+        config.nSize = sizeof (OMX_VIDEO_CONFIG_BITRATETYPE);
+        config.nVersion.s.nVersionMajor = 1;
+        config.nVersion.s.nVersionMinor = 1;
+
+        config.nPortIndex = 1;
+        OMX_GetConfig (gomx->omx_handle, OMX_IndexConfigVideoBitrate, &config);
+
+        config.nEncodeBitrate = bitrate;
+
+        GST_INFO_OBJECT (self, "setting bitrate: %u", bitrate);
+        omx_error = OMX_SetConfig (gomx->omx_handle, OMX_IndexConfigVideoBitrate, &config);
+        if (omx_error != OMX_ErrorNone)
+            GST_WARNING_OBJECT (self, "couldn't change bitrate: 0x%x", omx_error);
+    }
+}
+
+static void
+prepare_output (GstOmxBaseFilter *omx_base,
+                GstBuffer *buf,
+                OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    GstOmxBaseVideoEnc *self;
+    gboolean is_keyframe = FALSE;
+
+    self = GST_OMX_BASE_VIDEOENC (omx_base);
+
+    GST_OBJECT_LOCK (self);
+    if (self->in_frame)
+    {
+        /* rest of an access unit; same frame as the previous slice */
+        is_keyframe = self->forced_frame;
+    }
+    else if (self->keyframe_pending)
+    {
+        /* without timestamps the first frame out is the forced one */
+        if (!GST_CLOCK_TIME_IS_VALID (self->keyframe_timestamp) ||
+            !GST_BUFFER_TIMESTAMP_IS_VALID (buf) ||
+            GST_BUFFER_TIMESTAMP (buf) >= self->keyframe_timestamp)
+        {
+            /* only believe it if the component says so */
+            is_keyframe = (omx_buffer->nFlags & OMX_BUFFERFLAG_SYNCFRAME) != 0;
+            if (!is_keyframe)
+                GST_WARNING_OBJECT (self, "component ignored the keyframe request");
+            self->keyframe_pending = FALSE;
+        }
+    }
+    self->forced_frame = is_keyframe;
+    /* components only mark frame ends reliably when slicing was asked for */
+    self->in_frame = self->low_latency && !(omx_buffer->nFlags & OMX_BUFFERFLAG_ENDOFFRAME);
+    GST_OBJECT_UNLOCK (self);
+
+    if (is_keyframe)
+    {
+        GST_DEBUG_OBJECT (self, "forced keyframe: %" GST_TIME_FORMAT,
+                          GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
+        GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+    }
+}
+
+/* Pushes the gathered fragments as one buffer; that costs one copy of
+ * the compressed data, unless there's a single fragment. */
+static GstFlowReturn
+push_fragments (GstOmxBaseVideoEnc *self)
+{
+    GstOmxBaseFilter *omx_base;
+    GstBuffer *buf;
+    GstBuffer *first;
+    GSList *l;
+    guint offset;
+    gboolean keyframe = FALSE;
+
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    if (!self->fragments)
+        return GST_FLOW_OK;
+
+    if (!self->fragments->next)
+    {
+        buf = self->fragments->data;
+        g_slist_free (self->fragments);
+        self->fragments = NULL;
+        self->fragments_size = 0;
+
+        return gst_pad_push (omx_base->srcpad, buf);
+    }
+
+    self->fragments = g_slist_reverse (self->fragments);
+    first = self->fragments->data;
+
+    buf = gst_buffer_new_and_alloc (self->fragments_size);
+    gst_buffer_set_caps (buf, GST_PAD_CAPS (omx_base->srcpad));
+    GST_BUFFER_TIMESTAMP (buf) = GST_BUFFER_TIMESTAMP (first);
+
+    offset = 0;
+    for (l = self->fragments; l; l = l->next)
+    {
+        GstBuffer *fragment = l->data;
+
+        memcpy (GST_BUFFER_DATA (buf) + offset, GST_BUFFER_DATA (fragment), GST_BUFFER_SIZE (fragment));
+        offset += GST_BUFFER_SIZE (fragment);
+
+        /* parameter sets and slices of a keyframe may be flagged apart */
+        if (!GST_BUFFER_FLAG_IS_SET (fragment, GST_BUFFER_FLAG_DELTA_UNIT))
+            keyframe = TRUE;
+    }
+
+    if (!keyframe)
+        GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+    clear_fragments (self);
+
+    GST_LOG_OBJECT (self, "access unit: size=%u", GST_BUFFER_SIZE (buf));
+
+    return gst_pad_push (omx_base->srcpad, buf);
+}
+
+static GstFlowReturn
+push_output (GstOmxBaseFilter *omx_base,
+             GstBuffer *buf,
+             OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    GstOmxBaseVideoEnc *self;
+    GstFlowReturn ret = GST_FLOW_OK;
+
+    self = GST_OMX_BASE_VIDEOENC (omx_base);
+
+    if (self->output_mode == OUTPUT_MODE_PASSTHROUGH || self->low_latency)
+    {
+        /* in case the mode changed in the middle of a frame */
+        ret = push_fragments (self);
+        if (ret != GST_FLOW_OK)
+        {
+            gst_buffer_unref (buf);
+            return ret;
+        }
+
+        return gst_pad_push (omx_base->srcpad, buf);
+    }
+
+    /* not every component flags frame ends; a new timestamp is a new frame */
+    if (self->fragments &&
+        GST_BUFFER_TIMESTAMP (buf) != GST_BUFFER_TIMESTAMP (self->fragments->data))
+    {
+        ret = push_fragments (self);
+    }
+
+    self->fragments = g_slist_prepend (self->fragments, buf);
+    self->fragments_size += GST_BUFFER_SIZE (buf);
+
+    if (ret == GST_FLOW_OK && (omx_buffer->nFlags & OMX_BUFFERFLAG_ENDOFFRAME))
+        ret = push_fragments (self);
+
+    return ret;
+}
+
+static void
+drain_output (GstOmxBaseFilter *omx_base)
+{
+    push_fragments (GST_OMX_BASE_VIDEOENC (omx_base));
+}
+
 static void
 type_instance_init (GTypeInstance *instance,
                     gpointer g_class)
@@ -291,10 +1050,27 @@ type_instance_init (GTypeInstance *instance,
     self = GST_OMX_BASE_VIDEOENC (instance);
 
     omx_base->omx_setup = omx_setup;
+    omx_base->prepare_input = prepare_input;
+    omx_base->prepare_output = prepare_output;
+    omx_base->push_output = push_output;
+    omx_base->drain_output = drain_output;
 
     gst_pad_set_setcaps_function (omx_base->sinkpad, sink_setcaps);
 
+    self->base_sink_event = GST_PAD_EVENTFUNC (omx_base->sinkpad);
+    gst_pad_set_event_function (omx_base->sinkpad, sink_event);
+    gst_pad_set_event_function (omx_base->srcpad, src_event);
+
     self->bitrate = DEFAULT_BITRATE;
+    self->control_rate = DEFAULT_CONTROL_RATE;
+    self->p_frames = DEFAULT_P_FRAMES;
+    self->b_frames = DEFAULT_B_FRAMES;
+    self->quant_i = DEFAULT_QUANT;
+    self->quant_p = DEFAULT_QUANT;
+    self->quant_b = DEFAULT_QUANT;
+    self->low_latency = DEFAULT_LOW_LATENCY;
+    self->output_mode = DEFAULT_OUTPUT_MODE;
+    self->keyframe_timestamp = GST_CLOCK_TIME_NONE;
 }
 
 GType
@@ -28,6 +28,7 @@ G_BEGIN_DECLS
 
 #define GST_OMX_BASE_VIDEOENC(obj) (GstOmxBaseVideoEnc *) (obj)
 #define GST_OMX_BASE_VIDEOENC_TYPE (gst_omx_base_videoenc_get_type ())
+#define GST_OMX_BASE_VIDEOENC_CLASS(c) (G_TYPE_CHECK_CLASS_CAST ((c), GST_OMX_BASE_VIDEOENC_TYPE, GstOmxBaseVideoEncClass))
 
 typedef struct GstOmxBaseVideoEnc GstOmxBaseVideoEnc;
 typedef struct GstOmxBaseVideoEncClass GstOmxBaseVideoEncClass;
@@ -40,6 +41,29 @@ struct GstOmxBaseVideoEnc
 
     OMX_VIDEO_CODINGTYPE compression_format;
     guint bitrate;
+    gboolean bitrate_changed; /**< Needs to be applied before the next frame */
+
+    /* Encoding parameters; -1 (or 0 for profile/level) keeps the
+     * component's default. */
+    gint control_rate;
+    gint p_frames;
+    gint b_frames;
+    gint quant_i;
+    gint quant_p;
+    gint quant_b;
+    guint profile;
+    guint level;
+    gboolean low_latency;
+    gint output_mode;
+
+    GstPadEventFunction base_sink_event;
+    gboolean keyframe_requested; /**< Force an intra frame on the next input */
+    gboolean keyframe_pending; /**< Forced intra frame not pushed yet */
+    GstClockTime keyframe_timestamp;
+    gboolean in_frame; /**< Last output slice didn't end an access unit */
+    gboolean forced_frame; /**< Current access unit is a forced intra frame */
+    GSList *fragments; /**< Pieces of the access unit being gathered, newest first */
+    guint fragments_size;
     gint framerate_num;
     gint framerate_denom;
 };
@@ -47,9 +71,15 @@ struct GstOmxBaseVideoEnc
 struct GstOmxBaseVideoEncClass
 {
     GstOmxBaseFilterClass parent_class;
+
+    GType profile_type; /**< Of the "profile" property, 0 = component default */
+    GType level_type; /**< Of the "level" property, 0 = component default */
 };
 
 GType gst_omx_base_videoenc_get_type (void);
+void gst_omx_base_videoenc_class_add_profiles (GstOmxBaseVideoEncClass *klass,
+                                               const GEnumValue *profiles,
+                                               const GEnumValue *levels);
 
 G_END_DECLS
 
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gstomx_bitstream.h"
+
+#if defined (__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Helpers
+ */
+
+/* whether any of the 16 positions starting at data begins a zero pair;
+ * reads 17 bytes */
+static inline gboolean
+has_zero_pair (const guint8 *data)
+{
+#if defined (__ARM_NEON__)
+    uint8x16_t zero;
+    uint8x16_t m;
+    uint64x2_t m64;
+
+    zero = vdupq_n_u8 (0);
+    m = vandq_u8 (vceqq_u8 (vld1q_u8 (data), zero),
+                  vceqq_u8 (vld1q_u8 (data + 1), zero));
+    m64 = vreinterpretq_u64_u8 (m);
+
+    return (vgetq_lane_u64 (m64, 0) | vgetq_lane_u64 (m64, 1)) != 0;
+#elif defined (__SSE2__)
+    __m128i zero;
+    __m128i m;
+
+    zero = _mm_setzero_si128 ();
+    m = _mm_and_si128 (_mm_cmpeq_epi8 (_mm_loadu_si128 ((const __m128i *) data), zero),
+                       _mm_cmpeq_epi8 (_mm_loadu_si128 ((const __m128i *) (data + 1)), zero));
+
+    return _mm_movemask_epi8 (m) != 0;
+#else
+    return TRUE;
+#endif
+}
+
+/*
+ * Main
+ */
+
+/* Offset of the first two zero bytes followed by a byte matching
+ * value under mask; size when there's none. */
+guint
+g_omx_bitstream_find_start_code (const guint8 *data,
+                                 guint size,
+                                 guint8 mask,
+                                 guint8 value)
+{
+    guint i = 0;
+
+    while (i + 2 < size)
+    {
+        guint end;
+
+#if defined (__ARM_NEON__) || defined (__SSE2__)
+        if (i + 18 <= size)
+        {
+            /* most of the stream has no zero pairs at all */
+            if (!has_zero_pair (data + i))
+            {
+                i += 16;
+                continue;
+            }
+            end = i + 16;
+        }
+        else
+#endif
+            end = size - 2;
+
+        for (; i < end; i++)
+        {
+            if (data[i] == 0 && data[i + 1] == 0 &&
+                (data[i + 2] & mask) == value)
+                return i;
+        }
+    }
+
+    return size;
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef GSTOMX_BITSTREAM_H
+#define GSTOMX_BITSTREAM_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Functions. */
+
+guint g_omx_bitstream_find_start_code (const guint8 *data,
+                                       guint size,
+                                       guint8 mask,
+                                       guint8 value);
+
+G_END_DECLS
+
+#endif /* GSTOMX_BITSTREAM_H */
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gstomx_clock.h"
+
+static GstSystemClockClass *parent_class;
+
+static GstClockTime
+get_internal_time (GstClock *clock)
+{
+    GstOmxClock *self;
+    GstClockTime time;
+
+    self = GST_OMX_CLOCK (clock);
+
+    time = self->func (clock, self->user_data);
+
+    GST_OBJECT_LOCK (self);
+    if (!GST_CLOCK_TIME_IS_VALID (time) || time < self->last_time)
+        time = self->last_time;
+    else
+        self->last_time = time;
+    GST_OBJECT_UNLOCK (self);
+
+    return time;
+}
+
+static void
+type_class_init (gpointer g_class,
+                 gpointer class_data)
+{
+    GstClockClass *gstclock_class;
+
+    gstclock_class = GST_CLOCK_CLASS (g_class);
+
+    parent_class = g_type_class_ref (GST_TYPE_SYSTEM_CLOCK);
+
+    gstclock_class->get_internal_time = get_internal_time;
+}
+
+GstClock *
+gst_omx_clock_new (const gchar *name,
+                   GstOmxClockGetTimeFunc func,
+                   gpointer user_data)
+{
+    GstOmxClock *self;
+
+    self = g_object_new (GST_OMX_CLOCK_TYPE, "name", name, NULL);
+
+    self->func = func;
+    self->user_data = user_data;
+    self->last_time = 0;
+
+    return GST_CLOCK (self);
+}
+
+GType
+gst_omx_clock_get_type (void)
+{
+    static GType type = 0;
+
+    if (G_UNLIKELY (type == 0))
+    {
+        GTypeInfo *type_info;
+
+        type_info = g_new0 (GTypeInfo, 1);
+        type_info->class_size = sizeof (GstOmxClockClass);
+        type_info->class_init = type_class_init;
+        type_info->instance_size = sizeof (GstOmxClock);
+
+        type = g_type_register_static (GST_TYPE_SYSTEM_CLOCK, "GstOmxClock", type_info, 0);
+
+        g_free (type_info);
+    }
+
+    return type;
+}
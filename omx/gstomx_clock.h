@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef GSTOMX_CLOCK_H
+#define GSTOMX_CLOCK_H
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_OMX_CLOCK(obj) (GstOmxClock *) (obj)
+#define GST_OMX_CLOCK_TYPE (gst_omx_clock_get_type ())
+
+typedef struct GstOmxClock GstOmxClock;
+typedef struct GstOmxClockClass GstOmxClockClass;
+
+typedef GstClockTime (*GstOmxClockGetTimeFunc) (GstClock *clock, gpointer user_data);
+
+/* A system clock whose time comes from an element, such as the audio
+ * a component has played; waiting is left to the system clock. */
+struct GstOmxClock
+{
+    GstSystemClock clock;
+
+    GstOmxClockGetTimeFunc func;
+    gpointer user_data;
+    GstClockTime last_time; /**< Never goes back */
+};
+
+struct GstOmxClockClass
+{
+    GstSystemClockClass parent_class;
+};
+
+GType gst_omx_clock_get_type (void);
+GstClock *gst_omx_clock_new (const gchar *name, GstOmxClockGetTimeFunc func, gpointer user_data);
+
+G_END_DECLS
+
+#endif /* GSTOMX_CLOCK_H */
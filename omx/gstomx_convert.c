@@ -0,0 +1,986 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gstomx_convert.h"
+
+#include <gst/gst.h>
+
+#include <string.h> /* for memcpy, strcmp */
+
+#if defined (__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Helpers
+ */
+
+/* split n interleaved CbCr pairs into two planes */
+static inline void
+deinterleave_row (const guint8 *src,
+                  guint8 *dest_u,
+                  guint8 *dest_v,
+                  guint n)
+{
+    guint i = 0;
+
+#if defined (__ARM_NEON__)
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16x2_t uv;
+
+        uv = vld2q_u8 (src + 2 * i);
+        vst1q_u8 (dest_u + i, uv.val[0]);
+        vst1q_u8 (dest_v + i, uv.val[1]);
+    }
+#elif defined (__SSE2__)
+    {
+        const __m128i mask = _mm_set1_epi16 (0x00ff);
+
+        for (; i + 16 <= n; i += 16)
+        {
+            __m128i a;
+            __m128i b;
+
+            a = _mm_loadu_si128 ((const __m128i *) (src + 2 * i));
+            b = _mm_loadu_si128 ((const __m128i *) (src + 2 * i + 16));
+
+            _mm_storeu_si128 ((__m128i *) (dest_u + i),
+                              _mm_packus_epi16 (_mm_and_si128 (a, mask),
+                                                _mm_and_si128 (b, mask)));
+            _mm_storeu_si128 ((__m128i *) (dest_v + i),
+                              _mm_packus_epi16 (_mm_srli_epi16 (a, 8),
+                                                _mm_srli_epi16 (b, 8)));
+        }
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        dest_u[i] = src[2 * i];
+        dest_v[i] = src[2 * i + 1];
+    }
+}
+
+static inline gfloat
+load_float (const guint8 *p,
+            const GOmxPcmFormat *format)
+{
+    union { guint32 i; gfloat f; } v;
+
+    if (format->endianness == G_LITTLE_ENDIAN)
+        v.i = GST_READ_UINT32_LE (p);
+    else
+        v.i = GST_READ_UINT32_BE (p);
+
+    return v.f;
+}
+
+/* Rounded to nearest, halves away from zero; in single precision, step
+ * by step as the vector paths do it, so that all agree. */
+static inline gint16
+float_to_s16 (gfloat f)
+{
+    gfloat x;
+
+    x = f * 32768.0f;
+    x = CLAMP (x, -32768.0f, 32767.0f);
+    x += x < 0.0f ? -0.5f : 0.5f;
+
+    return (gint16) (gint32) x;
+}
+
+/* Full scale gint32 in between, so any pair of types converts. */
+static inline gint32
+load_sample (const guint8 *p,
+             const GOmxPcmFormat *format)
+{
+    switch (format->type)
+    {
+        case GOMX_PCM_S16:
+            {
+                gint16 v;
+
+                if (format->endianness == G_LITTLE_ENDIAN)
+                    v = (gint16) GST_READ_UINT16_LE (p);
+                else
+                    v = (gint16) GST_READ_UINT16_BE (p);
+
+                return (gint32) v * 65536;
+            }
+        case GOMX_PCM_S32:
+            if (format->endianness == G_LITTLE_ENDIAN)
+                return (gint32) GST_READ_UINT32_LE (p);
+            else
+                return (gint32) GST_READ_UINT32_BE (p);
+        case GOMX_PCM_F32:
+            {
+                gdouble d;
+
+                d = load_float (p, format) * 2147483648.0;
+                if (d >= 2147483647.0)
+                    return G_MAXINT32;
+                if (d <= -2147483648.0)
+                    return G_MININT32;
+                return (gint32) d;
+            }
+    }
+
+    return 0;
+}
+
+static inline void
+store_sample (guint8 *p,
+              const GOmxPcmFormat *format,
+              gint32 sample)
+{
+    switch (format->type)
+    {
+        case GOMX_PCM_S16:
+            if (format->endianness == G_LITTLE_ENDIAN)
+                GST_WRITE_UINT16_LE (p, (guint16) (sample >> 16));
+            else
+                GST_WRITE_UINT16_BE (p, (guint16) (sample >> 16));
+            break;
+        case GOMX_PCM_S32:
+            if (format->endianness == G_LITTLE_ENDIAN)
+                GST_WRITE_UINT32_LE (p, (guint32) sample);
+            else
+                GST_WRITE_UINT32_BE (p, (guint32) sample);
+            break;
+        case GOMX_PCM_F32:
+            {
+                union { guint32 i; gfloat f; } v;
+
+                v.f = sample * (1.0f / 2147483648.0f);
+
+                if (format->endianness == G_LITTLE_ENDIAN)
+                    GST_WRITE_UINT32_LE (p, v.i);
+                else
+                    GST_WRITE_UINT32_BE (p, v.i);
+                break;
+            }
+    }
+}
+
+static inline void
+convert_sample (const guint8 *src,
+                const GOmxPcmFormat *src_format,
+                guint8 *dest,
+                const GOmxPcmFormat *dest_format)
+{
+    /* only the byte order differs; floats must not lose precision */
+    if (src_format->type == dest_format->type)
+    {
+        guint width;
+        guint i;
+
+        width = g_omx_convert_pcm_width (src_format);
+
+        if (src_format->endianness == dest_format->endianness)
+        {
+            for (i = 0; i < width; i++)
+                dest[i] = src[i];
+        }
+        else
+        {
+            for (i = 0; i < width; i++)
+                dest[i] = src[width - 1 - i];
+        }
+        return;
+    }
+
+    /* straight to 16 bits, rounded like the vector paths */
+    if (src_format->type == GOMX_PCM_F32 && dest_format->type == GOMX_PCM_S16)
+    {
+        guint16 v;
+
+        v = (guint16) float_to_s16 (load_float (src, src_format));
+
+        if (dest_format->endianness == G_LITTLE_ENDIAN)
+            GST_WRITE_UINT16_LE (dest, v);
+        else
+            GST_WRITE_UINT16_BE (dest, v);
+        return;
+    }
+
+    store_sample (dest, dest_format, load_sample (src, src_format));
+}
+
+/* float_to_s16 on four samples, kept in 32 bits. */
+#if defined (__ARM_NEON__)
+static inline int32x4_t
+round_s16_f32 (float32x4_t f)
+{
+    float32x4_t x;
+    uint32x4_t sign;
+
+    x = vmulq_n_f32 (f, 32768.0f);
+    x = vminq_f32 (vmaxq_f32 (x, vdupq_n_f32 (-32768.0f)), vdupq_n_f32 (32767.0f));
+    sign = vandq_u32 (vreinterpretq_u32_f32 (x), vdupq_n_u32 (0x80000000));
+    x = vaddq_f32 (x, vreinterpretq_f32_u32 (vorrq_u32 (vreinterpretq_u32_f32 (vdupq_n_f32 (0.5f)), sign)));
+
+    return vcvtq_s32_f32 (x);
+}
+#elif defined (__SSE2__)
+static inline __m128i
+round_s16_ps (__m128 f)
+{
+    __m128 x;
+
+    x = _mm_mul_ps (f, _mm_set1_ps (32768.0f));
+    x = _mm_min_ps (_mm_max_ps (x, _mm_set1_ps (-32768.0f)), _mm_set1_ps (32767.0f));
+    x = _mm_add_ps (x, _mm_or_ps (_mm_set1_ps (0.5f), _mm_and_ps (x, _mm_set1_ps (-0.0f))));
+
+    return _mm_cvttps_epi32 (x);
+}
+#endif
+
+/* Vectorized conversion of n interleaved samples, for the cases that
+ * matter; returns how many were done, the rest is up to the caller. */
+static inline guint
+convert_run (const guint8 *src,
+             const GOmxPcmFormat *src_format,
+             guint8 *dest,
+             const GOmxPcmFormat *dest_format,
+             guint n)
+{
+    guint i = 0;
+
+    if (src_format->type == dest_format->type &&
+        src_format->endianness == dest_format->endianness)
+    {
+        memcpy (dest, src, n * g_omx_convert_pcm_width (src_format));
+        return n;
+    }
+
+    /* byte swap */
+    if (src_format->type == dest_format->type)
+    {
+        if (src_format->type == GOMX_PCM_S16)
+        {
+#if defined (__ARM_NEON__)
+            for (; i + 8 <= n; i += 8)
+                vst1q_u8 (dest + 2 * i, vrev16q_u8 (vld1q_u8 (src + 2 * i)));
+#elif defined (__SSE2__)
+            for (; i + 8 <= n; i += 8)
+            {
+                __m128i a;
+
+                a = _mm_loadu_si128 ((const __m128i *) (src + 2 * i));
+                a = _mm_or_si128 (_mm_slli_epi16 (a, 8), _mm_srli_epi16 (a, 8));
+                _mm_storeu_si128 ((__m128i *) (dest + 2 * i), a);
+            }
+#endif
+        }
+        else
+        {
+#if defined (__ARM_NEON__)
+            for (; i + 4 <= n; i += 4)
+                vst1q_u8 (dest + 4 * i, vrev32q_u8 (vld1q_u8 (src + 4 * i)));
+#elif defined (__SSE2__)
+            for (; i + 4 <= n; i += 4)
+            {
+                __m128i a;
+
+                a = _mm_loadu_si128 ((const __m128i *) (src + 4 * i));
+                a = _mm_or_si128 (_mm_slli_epi16 (a, 8), _mm_srli_epi16 (a, 8));
+                a = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (a, 0xb1), 0xb1);
+                _mm_storeu_si128 ((__m128i *) (dest + 4 * i), a);
+            }
+#endif
+        }
+        return i;
+    }
+
+    /* the vector paths only work in native byte order */
+    if (src_format->endianness != G_BYTE_ORDER ||
+        dest_format->endianness != G_BYTE_ORDER)
+        return 0;
+
+    if (src_format->type == GOMX_PCM_S16 && dest_format->type == GOMX_PCM_F32)
+    {
+        const gint16 *s = (const gint16 *) src;
+        gfloat *d = (gfloat *) dest;
+
+#if defined (__ARM_NEON__)
+        for (; i + 8 <= n; i += 8)
+        {
+            int16x8_t a;
+
+            a = vld1q_s16 (s + i);
+            vst1q_f32 (d + i, vcvtq_n_f32_s32 (vmovl_s16 (vget_low_s16 (a)), 15));
+            vst1q_f32 (d + i + 4, vcvtq_n_f32_s32 (vmovl_s16 (vget_high_s16 (a)), 15));
+        }
+#elif defined (__SSE2__)
+        const __m128 scale = _mm_set1_ps (1.0f / 32768.0f);
+
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128i a;
+            __m128i lo;
+            __m128i hi;
+
+            a = _mm_loadu_si128 ((const __m128i *) (s + i));
+            lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (a, a), 16);
+            hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (a, a), 16);
+            _mm_storeu_ps (d + i, _mm_mul_ps (_mm_cvtepi32_ps (lo), scale));
+            _mm_storeu_ps (d + i + 4, _mm_mul_ps (_mm_cvtepi32_ps (hi), scale));
+        }
+#endif
+        (void) s;
+        (void) d;
+    }
+    else if (src_format->type == GOMX_PCM_F32 && dest_format->type == GOMX_PCM_S16)
+    {
+        const gfloat *s = (const gfloat *) src;
+        gint16 *d = (gint16 *) dest;
+
+#if defined (__ARM_NEON__)
+        for (; i + 8 <= n; i += 8)
+        {
+            int16x4_t lo;
+            int16x4_t hi;
+
+            lo = vmovn_s32 (round_s16_f32 (vld1q_f32 (s + i)));
+            hi = vmovn_s32 (round_s16_f32 (vld1q_f32 (s + i + 4)));
+            vst1q_s16 (d + i, vcombine_s16 (lo, hi));
+        }
+#elif defined (__SSE2__)
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128i lo;
+            __m128i hi;
+
+            lo = round_s16_ps (_mm_loadu_ps (s + i));
+            hi = round_s16_ps (_mm_loadu_ps (s + i + 4));
+            _mm_storeu_si128 ((__m128i *) (d + i), _mm_packs_epi32 (lo, hi));
+        }
+#endif
+        (void) s;
+        (void) d;
+    }
+    else if (src_format->type == GOMX_PCM_S16 && dest_format->type == GOMX_PCM_S32)
+    {
+        const gint16 *s = (const gint16 *) src;
+        gint32 *d = (gint32 *) dest;
+
+#if defined (__ARM_NEON__)
+        for (; i + 8 <= n; i += 8)
+        {
+            int16x8_t a;
+
+            a = vld1q_s16 (s + i);
+            vst1q_s32 (d + i, vshll_n_s16 (vget_low_s16 (a), 16));
+            vst1q_s32 (d + i + 4, vshll_n_s16 (vget_high_s16 (a), 16));
+        }
+#elif defined (__SSE2__)
+        const __m128i zero = _mm_setzero_si128 ();
+
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128i a;
+
+            a = _mm_loadu_si128 ((const __m128i *) (s + i));
+            _mm_storeu_si128 ((__m128i *) (d + i), _mm_unpacklo_epi16 (zero, a));
+            _mm_storeu_si128 ((__m128i *) (d + i + 4), _mm_unpackhi_epi16 (zero, a));
+        }
+#endif
+        (void) s;
+        (void) d;
+    }
+    else if (src_format->type == GOMX_PCM_S32 && dest_format->type == GOMX_PCM_S16)
+    {
+        const gint32 *s = (const gint32 *) src;
+        gint16 *d = (gint16 *) dest;
+
+#if defined (__ARM_NEON__)
+        for (; i + 8 <= n; i += 8)
+        {
+            vst1q_s16 (d + i, vcombine_s16 (vshrn_n_s32 (vld1q_s32 (s + i), 16),
+                                            vshrn_n_s32 (vld1q_s32 (s + i + 4), 16)));
+        }
+#elif defined (__SSE2__)
+        for (; i + 8 <= n; i += 8)
+        {
+            __m128i lo;
+            __m128i hi;
+
+            lo = _mm_srai_epi32 (_mm_loadu_si128 ((const __m128i *) (s + i)), 16);
+            hi = _mm_srai_epi32 (_mm_loadu_si128 ((const __m128i *) (s + i + 4)), 16);
+            _mm_storeu_si128 ((__m128i *) (d + i), _mm_packs_epi32 (lo, hi));
+        }
+#endif
+        (void) s;
+        (void) d;
+    }
+
+    return i;
+}
+
+static void
+set_pcm_fields (GstStructure *structure,
+                const GOmxPcmFormat *format)
+{
+    gint width;
+
+    width = g_omx_convert_pcm_width (format) * 8;
+
+    if (format->type == GOMX_PCM_F32)
+    {
+        gst_structure_set_name (structure, "audio/x-raw-float");
+        gst_structure_remove_fields (structure, "depth", "signed", NULL);
+        gst_structure_set (structure,
+                           "width", G_TYPE_INT, width,
+                           "endianness", G_TYPE_INT, format->endianness,
+                           NULL);
+    }
+    else
+    {
+        gst_structure_set_name (structure, "audio/x-raw-int");
+        gst_structure_set (structure,
+                           "width", G_TYPE_INT, width,
+                           "depth", G_TYPE_INT, width,
+                           "signed", G_TYPE_BOOLEAN, TRUE,
+                           "endianness", G_TYPE_INT, format->endianness,
+                           NULL);
+    }
+}
+
+/* GstAudioChannelPosition, from gst/audio/multichannel.h; libgstaudio
+ * isn't linked, but the values are fixed. */
+enum
+{
+    POSITION_FRONT_MONO,
+    POSITION_FRONT_LEFT,
+    POSITION_FRONT_RIGHT,
+    POSITION_REAR_CENTER,
+    POSITION_REAR_LEFT,
+    POSITION_REAR_RIGHT,
+    POSITION_LFE,
+    POSITION_FRONT_CENTER,
+    POSITION_FRONT_LEFT_OF_CENTER,
+    POSITION_FRONT_RIGHT_OF_CENTER,
+    POSITION_SIDE_LEFT,
+    POSITION_SIDE_RIGHT,
+    POSITION_NONE
+};
+
+static OMX_AUDIO_CHANNELTYPE
+channel_from_position (gint position)
+{
+    switch (position)
+    {
+        case POSITION_FRONT_MONO: return OMX_AUDIO_ChannelCF;
+        case POSITION_FRONT_LEFT: return OMX_AUDIO_ChannelLF;
+        case POSITION_FRONT_RIGHT: return OMX_AUDIO_ChannelRF;
+        case POSITION_REAR_CENTER: return OMX_AUDIO_ChannelCS;
+        case POSITION_REAR_LEFT: return OMX_AUDIO_ChannelLR;
+        case POSITION_REAR_RIGHT: return OMX_AUDIO_ChannelRR;
+        case POSITION_LFE: return OMX_AUDIO_ChannelLFE;
+        case POSITION_FRONT_CENTER: return OMX_AUDIO_ChannelCF;
+        case POSITION_SIDE_LEFT: return OMX_AUDIO_ChannelLS;
+        case POSITION_SIDE_RIGHT: return OMX_AUDIO_ChannelRS;
+        default: return OMX_AUDIO_ChannelNone;
+    }
+}
+
+static gint
+position_from_channel (OMX_AUDIO_CHANNELTYPE channel,
+                       guint channels)
+{
+    switch (channel)
+    {
+        case OMX_AUDIO_ChannelLF: return POSITION_FRONT_LEFT;
+        case OMX_AUDIO_ChannelRF: return POSITION_FRONT_RIGHT;
+        case OMX_AUDIO_ChannelCF: return channels == 1 ? POSITION_FRONT_MONO : POSITION_FRONT_CENTER;
+        case OMX_AUDIO_ChannelLS: return POSITION_SIDE_LEFT;
+        case OMX_AUDIO_ChannelRS: return POSITION_SIDE_RIGHT;
+        case OMX_AUDIO_ChannelLFE: return POSITION_LFE;
+        case OMX_AUDIO_ChannelCS: return POSITION_REAR_CENTER;
+        case OMX_AUDIO_ChannelLR: return POSITION_REAR_LEFT;
+        case OMX_AUDIO_ChannelRR: return POSITION_REAR_RIGHT;
+        default: return POSITION_NONE;
+    }
+}
+
+/* Surround pairs are called side by some and rear by others. */
+static OMX_AUDIO_CHANNELTYPE
+channel_alias (OMX_AUDIO_CHANNELTYPE channel)
+{
+    switch (channel)
+    {
+        case OMX_AUDIO_ChannelLS: return OMX_AUDIO_ChannelLR;
+        case OMX_AUDIO_ChannelRS: return OMX_AUDIO_ChannelRR;
+        case OMX_AUDIO_ChannelLR: return OMX_AUDIO_ChannelLS;
+        case OMX_AUDIO_ChannelRR: return OMX_AUDIO_ChannelRS;
+        default: return OMX_AUDIO_ChannelNone;
+    }
+}
+
+static gint
+find_channel (const OMX_AUDIO_CHANNELTYPE *mapping,
+              guint channels,
+              OMX_AUDIO_CHANNELTYPE channel,
+              const gboolean *taken)
+{
+    guint i;
+
+    if (channel == OMX_AUDIO_ChannelNone)
+        return -1;
+
+    for (i = 0; i < channels; i++)
+    {
+        if (!taken[i] && mapping[i] == channel)
+            return i;
+    }
+
+    return -1;
+}
+
+/*
+ * Main
+ */
+
+/* Same layout as GStreamer's I420: rows padded to 4 bytes. */
+guint
+g_omx_convert_i420_size (guint width,
+                         guint height)
+{
+    guint y_stride;
+    guint uv_stride;
+    guint h;
+
+    y_stride = GST_ROUND_UP_4 (width);
+    uv_stride = GST_ROUND_UP_4 (GST_ROUND_UP_2 (width) / 2);
+    h = GST_ROUND_UP_2 (height);
+
+    return y_stride * h + uv_stride * h;
+}
+
+/* What g_omx_convert_nv12_to_i420 reads; a stride or slice height of 0
+ * means the same as the width or height. */
+guint
+g_omx_convert_nv12_size (guint src_stride,
+                         guint src_slice_height,
+                         guint width,
+                         guint height)
+{
+    guint uv_height;
+
+    if (src_stride == 0)
+        src_stride = width;
+    if (src_slice_height == 0)
+        src_slice_height = height;
+
+    uv_height = GST_ROUND_UP_2 (height) / 2;
+    if (uv_height == 0)
+        return 0;
+
+    /* the last chroma row needn't be padded to the stride */
+    return src_stride * (src_slice_height + uv_height - 1) + GST_ROUND_UP_2 (width);
+}
+
+void
+g_omx_convert_nv12_to_i420 (const guint8 *src,
+                            guint src_stride,
+                            guint src_slice_height,
+                            guint8 *dest,
+                            guint width,
+                            guint height)
+{
+    const guint8 *src_uv;
+    guint8 *dest_u;
+    guint8 *dest_v;
+    guint y_stride;
+    guint uv_stride;
+    guint uv_width;
+    guint uv_height;
+    guint i;
+
+    if (src_stride == 0)
+        src_stride = width;
+    if (src_slice_height == 0)
+        src_slice_height = height;
+
+    y_stride = GST_ROUND_UP_4 (width);
+    uv_stride = GST_ROUND_UP_4 (GST_ROUND_UP_2 (width) / 2);
+    uv_width = GST_ROUND_UP_2 (width) / 2;
+    uv_height = GST_ROUND_UP_2 (height) / 2;
+
+    src_uv = src + src_stride * src_slice_height;
+    dest_u = dest + y_stride * GST_ROUND_UP_2 (height);
+    dest_v = dest_u + uv_stride * uv_height;
+
+    if (src_stride == y_stride)
+    {
+        memcpy (dest, src, y_stride * height);
+    }
+    else
+    {
+        for (i = 0; i < height; i++)
+            memcpy (dest + i * y_stride, src + i * src_stride, width);
+    }
+
+    for (i = 0; i < uv_height; i++)
+    {
+        deinterleave_row (src_uv + i * src_stride,
+                          dest_u + i * uv_stride,
+                          dest_v + i * uv_stride,
+                          uv_width);
+    }
+}
+
+/* Converts while copying; interleaved and planar data may be mixed,
+ * planar meaning each channel's frames one after another. Channel c of
+ * dest comes from channel channel_map[c] of src, if there is a map. */
+void
+g_omx_convert_pcm (const guint8 *src,
+                   const GOmxPcmFormat *src_format,
+                   guint8 *dest,
+                   const GOmxPcmFormat *dest_format,
+                   guint channels,
+                   guint frames,
+                   const guint *channel_map)
+{
+    guint src_width;
+    guint dest_width;
+    guint c;
+    guint i;
+
+    src_width = g_omx_convert_pcm_width (src_format);
+    dest_width = g_omx_convert_pcm_width (dest_format);
+
+    if (!channel_map && !src_format->planar && !dest_format->planar)
+    {
+        guint n;
+
+        n = channels * frames;
+
+        for (i = convert_run (src, src_format, dest, dest_format, n); i < n; i++)
+        {
+            convert_sample (src + i * src_width, src_format,
+                            dest + i * dest_width, dest_format);
+        }
+        return;
+    }
+
+    for (c = 0; c < channels; c++)
+    {
+        guint from;
+
+        from = channel_map ? channel_map[c] : c;
+
+        for (i = 0; i < frames; i++)
+        {
+            guint s;
+            guint d;
+
+            s = src_format->planar ? from * frames + i : i * channels + from;
+            d = dest_format->planar ? c * frames + i : i * channels + c;
+
+            convert_sample (src + s * src_width, src_format,
+                            dest + d * dest_width, dest_format);
+        }
+    }
+}
+
+/* Bytes per sample of one channel. */
+guint
+g_omx_convert_pcm_width (const GOmxPcmFormat *format)
+{
+    return format->type == GOMX_PCM_S16 ? 2 : 4;
+}
+
+gboolean
+g_omx_convert_pcm_equal (const GOmxPcmFormat *a,
+                         const GOmxPcmFormat *b)
+{
+    return a->type == b->type &&
+        a->endianness == b->endianness &&
+        a->planar == b->planar;
+}
+
+/* FALSE if g_omx_convert_pcm can't handle it. */
+gboolean
+g_omx_convert_pcm_from_caps (GstStructure *structure,
+                             GOmxPcmFormat *format)
+{
+    const gchar *name;
+    gint width = 0;
+    gint depth = 0;
+    gint endianness = G_BYTE_ORDER;
+    gboolean is_signed = TRUE;
+
+    name = gst_structure_get_name (structure);
+
+    gst_structure_get_int (structure, "width", &width);
+    gst_structure_get_int (structure, "endianness", &endianness);
+
+    format->endianness = endianness;
+    format->planar = FALSE;
+
+    if (strcmp (name, "audio/x-raw-float") == 0)
+    {
+        format->type = GOMX_PCM_F32;
+        return width == 32;
+    }
+
+    if (strcmp (name, "audio/x-raw-int") != 0)
+        return FALSE;
+
+    depth = width;
+    gst_structure_get_int (structure, "depth", &depth);
+    gst_structure_get_boolean (structure, "signed", &is_signed);
+
+    if (!is_signed || depth != width)
+        return FALSE;
+
+    if (width == 16)
+        format->type = GOMX_PCM_S16;
+    else if (width == 32)
+        format->type = GOMX_PCM_S32;
+    else
+        return FALSE;
+
+    return TRUE;
+}
+
+gboolean
+g_omx_convert_pcm_from_omx (const OMX_AUDIO_PARAM_PCMMODETYPE *param,
+                            GOmxPcmFormat *format)
+{
+    format->endianness = (param->eEndian == OMX_EndianBig) ? G_BIG_ENDIAN : G_LITTLE_ENDIAN;
+    format->planar = !param->bInterleaved;
+
+    if (param->eNumData != OMX_NumericalDataSigned)
+        return FALSE;
+
+    if (param->nBitPerSample == 16)
+        format->type = GOMX_PCM_S16;
+    else if (param->nBitPerSample == 32)
+        format->type = GOMX_PCM_S32;
+    else
+        return FALSE;
+
+    return TRUE;
+}
+
+/* OpenMAX has no float samples; those become S32. */
+void
+g_omx_convert_pcm_to_omx (const GOmxPcmFormat *format,
+                          OMX_AUDIO_PARAM_PCMMODETYPE *param)
+{
+    param->eNumData = OMX_NumericalDataSigned;
+    param->eEndian = (format->endianness == G_BIG_ENDIAN) ? OMX_EndianBig : OMX_EndianLittle;
+    param->bInterleaved = !format->planar;
+    param->nBitPerSample = g_omx_convert_pcm_width (format) * 8;
+}
+
+/* Interleaved, as GStreamer has no planar audio. */
+GstCaps *
+g_omx_convert_pcm_to_caps (const GOmxPcmFormat *format,
+                           gint rate,
+                           gint channels)
+{
+    GstCaps *caps;
+
+    caps = gst_caps_new_simple ("audio/x-raw-int",
+                                "rate", G_TYPE_INT, rate,
+                                "channels", G_TYPE_INT, channels,
+                                NULL);
+
+    set_pcm_fields (gst_caps_get_structure (caps, 0), format);
+
+    return caps;
+}
+
+/* Appends every format g_omx_convert_pcm produces, with the rate and
+ * channels of the first structure; takes caps. */
+GstCaps *
+g_omx_convert_pcm_caps (GstCaps *caps)
+{
+    static const GOmxPcmFormat formats[] = {
+        { GOMX_PCM_S16, G_BYTE_ORDER, FALSE },
+        { GOMX_PCM_S32, G_BYTE_ORDER, FALSE },
+        { GOMX_PCM_F32, G_BYTE_ORDER, FALSE },
+        { GOMX_PCM_S16, G_BYTE_ORDER == G_LITTLE_ENDIAN ? G_BIG_ENDIAN : G_LITTLE_ENDIAN, FALSE },
+        { GOMX_PCM_S32, G_BYTE_ORDER == G_LITTLE_ENDIAN ? G_BIG_ENDIAN : G_LITTLE_ENDIAN, FALSE },
+        { GOMX_PCM_F32, G_BYTE_ORDER == G_LITTLE_ENDIAN ? G_BIG_ENDIAN : G_LITTLE_ENDIAN, FALSE },
+    };
+    GstStructure *base;
+    guint i;
+
+    caps = gst_caps_make_writable (caps);
+    base = gst_structure_copy (gst_caps_get_structure (caps, 0));
+
+    for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    {
+        GstStructure *structure;
+
+        structure = gst_structure_copy (base);
+        set_pcm_fields (structure, &formats[i]);
+        gst_caps_merge_structure (caps, structure);
+    }
+
+    gst_structure_free (base);
+
+    return caps;
+}
+
+/* The usual order for a channel count, when nothing says otherwise. */
+void
+g_omx_convert_channels_default (guint channels,
+                                OMX_AUDIO_CHANNELTYPE *mapping)
+{
+    static const OMX_AUDIO_CHANNELTYPE surround[] = {
+        OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF,
+        OMX_AUDIO_ChannelLFE, OMX_AUDIO_ChannelLR, OMX_AUDIO_ChannelRR,
+        OMX_AUDIO_ChannelLS, OMX_AUDIO_ChannelRS,
+    };
+    static const OMX_AUDIO_CHANNELTYPE quad[] = {
+        OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF,
+        OMX_AUDIO_ChannelLR, OMX_AUDIO_ChannelRR,
+    };
+    static const OMX_AUDIO_CHANNELTYPE five[] = {
+        OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF,
+        OMX_AUDIO_ChannelLR, OMX_AUDIO_ChannelRR,
+    };
+    guint i;
+
+    for (i = 0; i < channels && i < OMX_AUDIO_MAXCHANNELS; i++)
+    {
+        if (channels == 1)
+            mapping[i] = OMX_AUDIO_ChannelCF;
+        else if (channels == 4)
+            mapping[i] = quad[i];
+        else if (channels == 5)
+            mapping[i] = five[i];
+        else if (i < G_N_ELEMENTS (surround))
+            mapping[i] = surround[i];
+        else
+            mapping[i] = OMX_AUDIO_ChannelNone;
+    }
+}
+
+/* From channel-positions, or the default order without them. */
+void
+g_omx_convert_channels_from_caps (GstStructure *structure,
+                                  guint channels,
+                                  OMX_AUDIO_CHANNELTYPE *mapping)
+{
+    const GValue *positions;
+    guint i;
+
+    g_omx_convert_channels_default (channels, mapping);
+
+    positions = gst_structure_get_value (structure, "channel-positions");
+    if (!positions || !GST_VALUE_HOLDS_ARRAY (positions) ||
+        gst_value_array_get_size (positions) != channels)
+        return;
+
+    for (i = 0; i < channels && i < OMX_AUDIO_MAXCHANNELS; i++)
+    {
+        const GValue *position;
+
+        position = gst_value_array_get_value (positions, i);
+        if (!G_VALUE_HOLDS_ENUM (position))
+            return;
+
+        mapping[i] = channel_from_position (g_value_get_enum (position));
+    }
+}
+
+/* Only when GStreamer can express it, and there is more than stereo;
+ * otherwise the default order applies downstream. */
+void
+g_omx_convert_channels_to_caps (GstStructure *structure,
+                                guint channels,
+                                const OMX_AUDIO_CHANNELTYPE *mapping)
+{
+    GValue positions = { 0 };
+    GType type;
+    guint i;
+
+    if (channels <= 2 || channels > OMX_AUDIO_MAXCHANNELS)
+        return;
+
+    /* registered by libgstaudio, if anything uses it */
+    type = g_type_from_name ("GstAudioChannelPosition");
+    if (!type)
+        return;
+
+    for (i = 0; i < channels; i++)
+    {
+        if (position_from_channel (mapping[i], channels) == POSITION_NONE)
+            return;
+    }
+
+    g_value_init (&positions, GST_TYPE_ARRAY);
+
+    for (i = 0; i < channels; i++)
+    {
+        GValue position = { 0 };
+
+        g_value_init (&position, type);
+        g_value_set_enum (&position, position_from_channel (mapping[i], channels));
+        gst_value_array_append_value (&positions, &position);
+        g_value_unset (&position);
+    }
+
+    gst_structure_set_value (structure, "channel-positions", &positions);
+    g_value_unset (&positions);
+}
+
+/* Where each channel of the 'to' layout is in the 'from' one; FALSE if
+ * they are the same, or don't have the same channels. */
+gboolean
+g_omx_convert_channel_map (const OMX_AUDIO_CHANNELTYPE *from,
+                           const OMX_AUDIO_CHANNELTYPE *to,
+                           guint channels,
+                           guint *channel_map)
+{
+    gboolean taken[OMX_AUDIO_MAXCHANNELS] = { FALSE };
+    gboolean identity = TRUE;
+    guint i;
+
+    if (channels > OMX_AUDIO_MAXCHANNELS)
+        return FALSE;
+
+    for (i = 0; i < channels; i++)
+    {
+        gint c;
+
+        c = find_channel (from, channels, to[i], taken);
+        if (c < 0)
+            c = find_channel (from, channels, channel_alias (to[i]), taken);
+        if (c < 0)
+            return FALSE;
+
+        taken[c] = TRUE;
+        channel_map[i] = c;
+
+        if ((guint) c != i)
+            identity = FALSE;
+    }
+
+    return !identity;
+}
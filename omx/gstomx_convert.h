@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef GSTOMX_CONVERT_H
+#define GSTOMX_CONVERT_H
+
+#include <gst/gst.h>
+#include <OMX_Audio.h>
+
+G_BEGIN_DECLS
+
+/* Typedefs. */
+
+typedef struct GOmxPcmFormat GOmxPcmFormat;
+typedef enum GOmxPcmType GOmxPcmType;
+
+/* Enums. */
+
+enum GOmxPcmType
+{
+    GOMX_PCM_S16,
+    GOMX_PCM_S32,
+    GOMX_PCM_F32
+};
+
+/* Structures. */
+
+struct GOmxPcmFormat
+{
+    GOmxPcmType type;
+    gint endianness; /**< G_LITTLE_ENDIAN or G_BIG_ENDIAN */
+    gboolean planar; /**< Each channel in a block of its own, instead of interleaved */
+};
+
+/* Functions. */
+
+void g_omx_convert_nv12_to_i420 (const guint8 *src,
+                                 guint src_stride,
+                                 guint src_slice_height,
+                                 guint8 *dest,
+                                 guint width,
+                                 guint height);
+
+guint g_omx_convert_i420_size (guint width, guint height);
+guint g_omx_convert_nv12_size (guint src_stride, guint src_slice_height, guint width, guint height);
+
+void g_omx_convert_pcm (const guint8 *src,
+                        const GOmxPcmFormat *src_format,
+                        guint8 *dest,
+                        const GOmxPcmFormat *dest_format,
+                        guint channels,
+                        guint frames,
+                        const guint *channel_map);
+
+guint g_omx_convert_pcm_width (const GOmxPcmFormat *format);
+gboolean g_omx_convert_pcm_equal (const GOmxPcmFormat *a, const GOmxPcmFormat *b);
+gboolean g_omx_convert_pcm_from_caps (GstStructure *structure, GOmxPcmFormat *format);
+gboolean g_omx_convert_pcm_from_omx (const OMX_AUDIO_PARAM_PCMMODETYPE *param, GOmxPcmFormat *format);
+void g_omx_convert_pcm_to_omx (const GOmxPcmFormat *format, OMX_AUDIO_PARAM_PCMMODETYPE *param);
+GstCaps *g_omx_convert_pcm_to_caps (const GOmxPcmFormat *format, gint rate, gint channels);
+GstCaps *g_omx_convert_pcm_caps (GstCaps *caps);
+
+void g_omx_convert_channels_default (guint channels, OMX_AUDIO_CHANNELTYPE *mapping);
+void g_omx_convert_channels_from_caps (GstStructure *structure, guint channels, OMX_AUDIO_CHANNELTYPE *mapping);
+void g_omx_convert_channels_to_caps (GstStructure *structure, guint channels, const OMX_AUDIO_CHANNELTYPE *mapping);
+gboolean g_omx_convert_channel_map (const OMX_AUDIO_CHANNELTYPE *from,
+                                    const OMX_AUDIO_CHANNELTYPE *to,
+                                    guint channels,
+                                    guint *channel_map);
+
+G_END_DECLS
+
+#endif /* GSTOMX_CONVERT_H */
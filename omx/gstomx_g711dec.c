@@ -20,12 +20,11 @@
  */
 
 #include "gstomx_g711dec.h"
-#include "gstomx_base_filter.h"
 #include "gstomx.h"
 
 #include <string.h> /* for memset, strcmp */
 
-static GstOmxBaseFilterClass *parent_class;
+static GstOmxBaseAudioDecClass *parent_class;
 
 static GstCaps *
 generate_src_template (void)
@@ -41,7 +40,7 @@ generate_src_template (void)
                                 "channels", G_TYPE_INT, 1,
                                 NULL);
 
-    return caps;
+    return g_omx_convert_pcm_caps (caps);
 }
 
 static GstCaps *
@@ -112,7 +111,7 @@ static void
 type_class_init (gpointer g_class,
                  gpointer class_data)
 {
-    parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+    parent_class = g_type_class_ref (GST_OMX_BASE_AUDIODEC_TYPE);
 }
 
 static gboolean
@@ -186,6 +185,9 @@ type_instance_init (GTypeInstance *instance,
 
     omx_base = GST_OMX_BASE_FILTER (instance);
 
+    /* the src caps follow the sink caps */
+    omx_base->gomx->settings_changed_cb = NULL;
+
     gst_pad_set_setcaps_function (omx_base->sinkpad, sink_setcaps);
 }
 
@@ -205,7 +207,7 @@ gst_omx_g711dec_get_type (void)
         type_info->instance_size = sizeof (GstOmxG711Dec);
         type_info->instance_init = type_instance_init;
 
-        type = g_type_register_static (GST_OMX_BASE_FILTER_TYPE, "GstOmxG711Dec", type_info, 0);
+        type = g_type_register_static (GST_OMX_BASE_AUDIODEC_TYPE, "GstOmxG711Dec", type_info, 0);
 
         g_free (type_info);
     }
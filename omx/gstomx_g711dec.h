@@ -32,16 +32,16 @@ G_BEGIN_DECLS
 typedef struct GstOmxG711Dec GstOmxG711Dec;
 typedef struct GstOmxG711DecClass GstOmxG711DecClass;
 
-#include "gstomx_base_filter.h"
+#include "gstomx_base_audiodec.h"
 
 struct GstOmxG711Dec
 {
-    GstOmxBaseFilter omx_base;
+    GstOmxBaseAudioDec omx_base;
 };
 
 struct GstOmxG711DecClass
 {
-    GstOmxBaseFilterClass parent_class;
+    GstOmxBaseAudioDecClass parent_class;
 };
 
 GType gst_omx_g711dec_get_type (void);
@@ -20,12 +20,11 @@
  */
 
 #include "gstomx_g711enc.h"
-#include "gstomx_base_filter.h"
 #include "gstomx.h"
 
 #include <string.h> /* for memset, strcmp */
 
-static GstOmxBaseFilterClass *parent_class;
+static GstOmxBaseAudioEncClass *parent_class;
 
 static GstCaps *
 generate_src_template (void)
@@ -112,7 +111,7 @@ static void
 type_class_init (gpointer g_class,
                  gpointer class_data)
 {
-    parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+    parent_class = g_type_class_ref (GST_OMX_BASE_AUDIOENC_TYPE);
 }
 
 static gboolean
@@ -201,6 +200,9 @@ type_instance_init (GTypeInstance *instance,
     omx_base = GST_OMX_BASE_FILTER (instance);
 
     gst_pad_set_setcaps_function (omx_base->sinkpad, sink_setcaps);
+
+    /* no codec frames as such; packetize by 10 ms */
+    GST_OMX_BASE_AUDIOENC (instance)->frame_duration = 10 * GST_MSECOND;
 }
 
 GType
@@ -219,7 +221,7 @@ gst_omx_g711enc_get_type (void)
         type_info->instance_size = sizeof (GstOmxG711Enc);
         type_info->instance_init = type_instance_init;
 
-        type = g_type_register_static (GST_OMX_BASE_FILTER_TYPE, "GstOmxG711Enc", type_info, 0);
+        type = g_type_register_static (GST_OMX_BASE_AUDIOENC_TYPE, "GstOmxG711Enc", type_info, 0);
 
         g_free (type_info);
     }
@@ -32,16 +32,16 @@ G_BEGIN_DECLS
 typedef struct GstOmxG711Enc GstOmxG711Enc;
 typedef struct GstOmxG711EncClass GstOmxG711EncClass;
 
-#include "gstomx_base_filter.h"
+#include "gstomx_base_audioenc.h"
 
 struct GstOmxG711Enc
 {
-    GstOmxBaseFilter omx_base;
+    GstOmxBaseAudioEnc omx_base;
 };
 
 struct GstOmxG711EncClass
 {
-    GstOmxBaseFilterClass parent_class;
+    GstOmxBaseAudioEncClass parent_class;
 };
 
 GType gst_omx_g711enc_get_type (void);
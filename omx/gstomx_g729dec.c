@@ -20,10 +20,9 @@
  */
 
 #include "gstomx_g729dec.h"
-#include "gstomx_base_filter.h"
 #include "gstomx.h"
 
-static GstOmxBaseFilterClass *parent_class;
+static GstOmxBaseAudioDecClass *parent_class;
 
 static GstCaps *
 generate_src_template (void)
@@ -39,7 +38,7 @@ generate_src_template (void)
                                 "channels", G_TYPE_INT, 1,
                                 NULL);
 
-    return caps;
+    return g_omx_convert_pcm_caps (caps);
 }
 
 static GstCaps *
@@ -103,7 +102,7 @@ static void
 type_class_init (gpointer g_class,
                  gpointer class_data)
 {
-    parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+    parent_class = g_type_class_ref (GST_OMX_BASE_AUDIODEC_TYPE);
 }
 
 static void
@@ -159,7 +158,7 @@ gst_omx_g729dec_get_type (void)
         type_info->instance_size = sizeof (GstOmxG729Dec);
         type_info->instance_init = type_instance_init;
 
-        type = g_type_register_static (GST_OMX_BASE_FILTER_TYPE, "GstOmxG729Dec", type_info, 0);
+        type = g_type_register_static (GST_OMX_BASE_AUDIODEC_TYPE, "GstOmxG729Dec", type_info, 0);
 
         g_free (type_info);
     }
@@ -20,7 +20,6 @@
  */
 
 #include "gstomx_g729enc.h"
-#include "gstomx_base_filter.h"
 #include "gstomx.h"
 
 #include <string.h> /* for memset */
@@ -33,7 +32,7 @@ enum
     ARG_DTX,
 };
 
-static GstOmxBaseFilterClass *parent_class;
+static GstOmxBaseAudioEncClass *parent_class;
 
 static GstCaps *
 generate_src_template (void)
@@ -160,7 +159,7 @@ type_class_init (gpointer g_class,
 
     gobject_class = G_OBJECT_CLASS (g_class);
 
-    parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+    parent_class = g_type_class_ref (GST_OMX_BASE_AUDIOENC_TYPE);
 
     /* Properties stuff */
     {
@@ -257,6 +256,7 @@ type_instance_init (GTypeInstance *instance,
 
     gst_pad_set_setcaps_function (omx_base->sinkpad, sink_setcaps);
 
+    GST_OMX_BASE_AUDIOENC (self)->frame_duration = 10 * GST_MSECOND;
     self->dtx = DEFAULT_DTX;
 }
 
@@ -276,7 +276,7 @@ gst_omx_g729enc_get_type (void)
         type_info->instance_size = sizeof (GstOmxG729Enc);
         type_info->instance_init = type_instance_init;
 
-        type = g_type_register_static (GST_OMX_BASE_FILTER_TYPE, "GstOmxG729Enc", type_info, 0);
+        type = g_type_register_static (GST_OMX_BASE_AUDIOENC_TYPE, "GstOmxG729Enc", type_info, 0);
 
         g_free (type_info);
     }
@@ -32,17 +32,17 @@ G_BEGIN_DECLS
 typedef struct GstOmxG729Enc GstOmxG729Enc;
 typedef struct GstOmxG729EncClass GstOmxG729EncClass;
 
-#include "gstomx_base_filter.h"
+#include "gstomx_base_audioenc.h"
 
 struct GstOmxG729Enc
 {
-    GstOmxBaseFilter omx_base;
+    GstOmxBaseAudioEnc omx_base;
     gboolean dtx;
 };
 
 struct GstOmxG729EncClass
 {
-    GstOmxBaseFilterClass parent_class;
+    GstOmxBaseAudioEncClass parent_class;
 };
 
 GType gst_omx_g729enc_get_type (void);
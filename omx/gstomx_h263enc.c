@@ -26,6 +26,33 @@
 
 static GstOmxBaseFilterClass *parent_class;
 
+static const GEnumValue profiles[] = {
+    {0, "Component default", "default"},
+    {OMX_VIDEO_H263ProfileBaseline, "Baseline profile", "baseline"},
+    {OMX_VIDEO_H263ProfileH320Coding, "H.320 coding efficiency profile", "h320-coding"},
+    {OMX_VIDEO_H263ProfileBackwardCompatible, "Backward compatibility profile", "backward-compatible"},
+    {OMX_VIDEO_H263ProfileISWV2, "Interactive streaming wireless profile (V2)", "isw-v2"},
+    {OMX_VIDEO_H263ProfileISWV3, "Interactive streaming wireless profile (V3)", "isw-v3"},
+    {OMX_VIDEO_H263ProfileHighCompression, "Conversational high compression profile", "high-compression"},
+    {OMX_VIDEO_H263ProfileInternet, "Conversational internet profile", "internet"},
+    {OMX_VIDEO_H263ProfileInterlace, "Conversational interlace profile", "interlace"},
+    {OMX_VIDEO_H263ProfileHighLatency, "High latency profile", "high-latency"},
+    {0, NULL, NULL},
+};
+
+static const GEnumValue levels[] = {
+    {0, "Component default", "default"},
+    {OMX_VIDEO_H263Level10, "Level 10", "10"},
+    {OMX_VIDEO_H263Level20, "Level 20", "20"},
+    {OMX_VIDEO_H263Level30, "Level 30", "30"},
+    {OMX_VIDEO_H263Level40, "Level 40", "40"},
+    {OMX_VIDEO_H263Level45, "Level 45", "45"},
+    {OMX_VIDEO_H263Level50, "Level 50", "50"},
+    {OMX_VIDEO_H263Level60, "Level 60", "60"},
+    {OMX_VIDEO_H263Level70, "Level 70", "70"},
+    {0, NULL, NULL},
+};
+
 static GstCaps *
 generate_src_template (void)
 {
@@ -75,6 +102,9 @@ type_class_init (gpointer g_class,
                  gpointer class_data)
 {
     parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+
+    gst_omx_base_videoenc_class_add_profiles (GST_OMX_BASE_VIDEOENC_CLASS (g_class),
+                                              profiles, levels);
 }
 
 static void
@@ -22,8 +22,46 @@
 #include "gstomx_h264dec.h"
 #include "gstomx.h"
 
+#include <string.h> /* for memcpy */
+
 static GstOmxBaseVideoDecClass *parent_class;
 
+static const guint8 start_code[4] = { 0, 0, 0, 1 };
+
+static const GstOmxVideoName profiles[] =
+{
+    { OMX_VIDEO_AVCProfileBaseline, "baseline" },
+    { OMX_VIDEO_AVCProfileBaseline, "constrained-baseline" },
+    { OMX_VIDEO_AVCProfileMain, "main" },
+    { OMX_VIDEO_AVCProfileExtended, "extended" },
+    { OMX_VIDEO_AVCProfileHigh, "high" },
+    { OMX_VIDEO_AVCProfileHigh10, "high-10" },
+    { OMX_VIDEO_AVCProfileHigh422, "high-4:2:2" },
+    { OMX_VIDEO_AVCProfileHigh444, "high-4:4:4" },
+    { 0, NULL },
+};
+
+static const GstOmxVideoName levels[] =
+{
+    { OMX_VIDEO_AVCLevel1, "1" },
+    { OMX_VIDEO_AVCLevel1b, "1b" },
+    { OMX_VIDEO_AVCLevel11, "1.1" },
+    { OMX_VIDEO_AVCLevel12, "1.2" },
+    { OMX_VIDEO_AVCLevel13, "1.3" },
+    { OMX_VIDEO_AVCLevel2, "2" },
+    { OMX_VIDEO_AVCLevel21, "2.1" },
+    { OMX_VIDEO_AVCLevel22, "2.2" },
+    { OMX_VIDEO_AVCLevel3, "3" },
+    { OMX_VIDEO_AVCLevel31, "3.1" },
+    { OMX_VIDEO_AVCLevel32, "3.2" },
+    { OMX_VIDEO_AVCLevel4, "4" },
+    { OMX_VIDEO_AVCLevel41, "4.1" },
+    { OMX_VIDEO_AVCLevel42, "4.2" },
+    { OMX_VIDEO_AVCLevel5, "5" },
+    { OMX_VIDEO_AVCLevel51, "5.1" },
+    { 0, NULL },
+};
+
 static GstCaps *
 generate_sink_template (void)
 {
@@ -66,7 +104,9 @@ type_base_init (gpointer g_class)
 
         template = gst_pad_template_new ("sink", GST_PAD_SINK,
                                          GST_PAD_ALWAYS,
-                                         generate_sink_template ());
+                                         gst_omx_base_videodec_probe_sink_caps (g_class,
+                                                                                generate_sink_template (),
+                                                                                profiles, levels));
 
         gst_element_class_add_pad_template (element_class, template);
     }
@@ -79,15 +119,341 @@ type_class_init (gpointer g_class,
     parent_class = g_type_class_ref (GST_OMX_BASE_VIDEODEC_TYPE);
 }
 
+/* Turns an avcC record into SPS and PPS NAL units with start codes. */
+static GstBuffer *
+avcc_to_byte_stream (GstBuffer *avcc,
+                     guint *nal_length_size)
+{
+    const guint8 *data;
+    guint size;
+    guint offset;
+    guint out_size;
+    guint num;
+    guint i;
+    guint j;
+    GstBuffer *buf;
+    guint8 *out;
+
+    data = GST_BUFFER_DATA (avcc);
+    size = GST_BUFFER_SIZE (avcc);
+
+    if (size < 7 || data[0] != 1)
+        return NULL;
+
+    *nal_length_size = (data[4] & 0x03) + 1;
+
+    /* first pass: validate and measure */
+    offset = 5;
+    out_size = 0;
+    for (i = 0; i < 2; i++)
+    {
+        if (offset >= size)
+            return NULL;
+
+        /* 5 bits of SPS count, then 8 bits of PPS count */
+        num = (i == 0) ? (data[offset] & 0x1f) : data[offset];
+        offset++;
+
+        for (j = 0; j < num; j++)
+        {
+            guint nal_size;
+
+            if (offset + 2 > size)
+                return NULL;
+
+            nal_size = GST_READ_UINT16_BE (data + offset);
+            offset += 2;
+
+            if (nal_size > size - offset)
+                return NULL;
+
+            offset += nal_size;
+            out_size += sizeof (start_code) + nal_size;
+        }
+    }
+
+    buf = gst_buffer_new_and_alloc (out_size);
+    out = GST_BUFFER_DATA (buf);
+
+    offset = 5;
+    for (i = 0; i < 2; i++)
+    {
+        num = (i == 0) ? (data[offset] & 0x1f) : data[offset];
+        offset++;
+
+        for (j = 0; j < num; j++)
+        {
+            guint nal_size;
+
+            nal_size = GST_READ_UINT16_BE (data + offset);
+            offset += 2;
+
+            memcpy (out, start_code, sizeof (start_code));
+            memcpy (out + sizeof (start_code), data + offset, nal_size);
+
+            out += sizeof (start_code) + nal_size;
+            offset += nal_size;
+        }
+    }
+
+    return buf;
+}
+
+/* 4-byte lengths and start codes take the same room, so the NAL units
+ * stay where they are and only the prefixes are overwritten as the data
+ * is copied into the OpenMAX buffer; a prefix may straddle two of them.
+ * The chunks of a buffer come in order, so the walk goes on from where
+ * the previous one left it. */
+static void
+in_copy (GstOmxBaseFilter *omx_base,
+         guint8 *dest,
+         GstBuffer *buf,
+         guint offset,
+         guint size)
+{
+    GstOmxH264Dec *self;
+    const guint8 *data;
+    guint total;
+    guint pos;
+
+    self = GST_OMX_H264DEC (omx_base);
+
+    data = GST_BUFFER_DATA (buf);
+    total = GST_BUFFER_SIZE (buf);
+
+    memcpy (dest, data + offset, size);
+
+    pos = offset == 0 ? 0 : self->nal_pos;
+    while (pos + 4 <= total && pos < offset + size)
+    {
+        guint nal_size;
+        guint i;
+
+        nal_size = GST_READ_UINT32_BE (data + pos);
+
+        for (i = 0; i < 4; i++)
+        {
+            if (pos + i >= offset && pos + i < offset + size)
+                dest[pos + i - offset] = start_code[i];
+        }
+
+        /* the rest of the prefix is in the next chunk */
+        if (pos + 4 > offset + size)
+            break;
+
+        if (nal_size > total - pos - 4)
+            break;
+
+        pos += 4 + nal_size;
+    }
+
+    self->nal_pos = pos;
+}
+
+/* Shorter prefixes than start codes; the NAL units have to move, so
+ * these streams go through a new buffer. */
+static GstBuffer *
+nal_to_byte_stream (GstBuffer *buf,
+                    guint nal_length_size)
+{
+    const guint8 *data;
+    guint size;
+    guint pos;
+    guint out_size;
+    GstBuffer *out_buf;
+    guint8 *out;
+
+    data = GST_BUFFER_DATA (buf);
+    size = GST_BUFFER_SIZE (buf);
+
+    /* first pass: measure; a truncated unit ends it */
+    pos = 0;
+    out_size = 0;
+    while (pos + nal_length_size <= size)
+    {
+        guint nal_size = 0;
+        guint i;
+
+        for (i = 0; i < nal_length_size; i++)
+            nal_size = (nal_size << 8) | data[pos + i];
+
+        if (nal_size > size - pos - nal_length_size)
+            break;
+
+        pos += nal_length_size + nal_size;
+        out_size += sizeof (start_code) + nal_size;
+    }
+
+    out_buf = gst_buffer_new_and_alloc (out_size);
+    gst_buffer_copy_metadata (out_buf, buf, GST_BUFFER_COPY_FLAGS |
+                              GST_BUFFER_COPY_TIMESTAMPS | GST_BUFFER_COPY_CAPS);
+    out = GST_BUFFER_DATA (out_buf);
+
+    pos = 0;
+    while (out < GST_BUFFER_DATA (out_buf) + out_size)
+    {
+        guint nal_size = 0;
+        guint i;
+
+        for (i = 0; i < nal_length_size; i++)
+            nal_size = (nal_size << 8) | data[pos + i];
+
+        memcpy (out, start_code, sizeof (start_code));
+        memcpy (out + sizeof (start_code), data + pos + nal_length_size, nal_size);
+
+        out += sizeof (start_code) + nal_size;
+        pos += nal_length_size + nal_size;
+    }
+
+    return out_buf;
+}
+
+static GstFlowReturn
+pad_chain (GstPad *pad,
+           GstBuffer *buf)
+{
+    GstOmxH264Dec *self;
+    GstBuffer *out_buf;
+
+    self = GST_OMX_H264DEC (GST_PAD_PARENT (pad));
+
+    if (!self->nal_length_size)
+        return self->base_chain (pad, buf);
+
+    out_buf = nal_to_byte_stream (buf, self->nal_length_size);
+    gst_buffer_unref (buf);
+
+    return self->base_chain (pad, out_buf);
+}
+
+/* Profile and level from the avcC record, when the caps don't have them,
+ * so that unsupported streams are refused like with the caps. */
+static gboolean
+avcc_supported (GstPad *pad,
+                GstCaps *caps)
+{
+    GstStructure *structure;
+    const GValue *codec_data;
+    const guint8 *data;
+    const gchar *profile;
+    gchar *level;
+    GstCaps *avcc_caps;
+    GstCaps *common;
+    gboolean supported;
+
+    structure = gst_caps_get_structure (caps, 0);
+
+    if (gst_structure_has_field (structure, "profile"))
+        return TRUE;
+
+    codec_data = gst_structure_get_value (structure, "codec_data");
+    if (!codec_data)
+        return TRUE;
+
+    data = GST_BUFFER_DATA (gst_value_get_buffer (codec_data));
+    if (GST_BUFFER_SIZE (gst_value_get_buffer (codec_data)) < 4 || data[0] != 1)
+        return TRUE;
+
+    switch (data[1])
+    {
+        case 66: profile = "baseline"; break;
+        case 77: profile = "main"; break;
+        case 88: profile = "extended"; break;
+        case 100: profile = "high"; break;
+        case 110: profile = "high-10"; break;
+        case 122: profile = "high-4:2:2"; break;
+        case 244: profile = "high-4:4:4"; break;
+        default: return TRUE;
+    }
+
+    /* level 1b is 11 with constraint_set3_flag in baseline */
+    if (data[3] == 9 || (data[3] == 11 && data[1] == 66 && (data[2] & 0x10)))
+        level = g_strdup ("1b");
+    else if (data[3] % 10 == 0)
+        level = g_strdup_printf ("%u", (guint) data[3] / 10);
+    else
+        level = g_strdup_printf ("%u.%u", (guint) data[3] / 10, (guint) data[3] % 10);
+
+    avcc_caps = gst_caps_copy (caps);
+    gst_caps_set_simple (avcc_caps,
+                         "profile", G_TYPE_STRING, profile,
+                         "level", G_TYPE_STRING, level,
+                         NULL);
+
+    common = gst_caps_intersect (avcc_caps, gst_pad_get_pad_template_caps (pad));
+    supported = !gst_caps_is_empty (common);
+
+    if (!supported)
+        GST_WARNING_OBJECT (GST_PAD_PARENT (pad), "profile %s, level %s not supported", profile, level);
+
+    gst_caps_unref (common);
+    gst_caps_unref (avcc_caps);
+    g_free (level);
+
+    return supported;
+}
+
+static gboolean
+sink_setcaps (GstPad *pad,
+              GstCaps *caps)
+{
+    GstOmxH264Dec *self;
+    GstOmxBaseFilter *omx_base;
+    GstBuffer *byte_stream = NULL;
+    guint nal_length_size = 0;
+
+    self = GST_OMX_H264DEC (GST_PAD_PARENT (pad));
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    if (!avcc_supported (pad, caps))
+        return FALSE;
+
+    if (!self->base_setcaps (pad, caps))
+        return FALSE;
+
+    omx_base->in_copy = NULL;
+    self->nal_length_size = 0;
+
+    if (omx_base->codec_data)
+        byte_stream = avcc_to_byte_stream (omx_base->codec_data, &nal_length_size);
+
+    if (!byte_stream)
+        return TRUE;
+
+    GST_INFO_OBJECT (self, "avcC stream, %u byte lengths; converting to byte-stream",
+                     nal_length_size);
+
+    gst_buffer_unref (omx_base->codec_data);
+    omx_base->codec_data = byte_stream;
+
+    /* 4 byte lengths are rewritten in place, as the data is copied */
+    if (nal_length_size == 4)
+        omx_base->in_copy = in_copy;
+    else
+        self->nal_length_size = nal_length_size;
+
+    return TRUE;
+}
+
 static void
 type_instance_init (GTypeInstance *instance,
                     gpointer g_class)
 {
+    GstOmxBaseFilter *omx_base_filter;
     GstOmxBaseVideoDec *omx_base;
+    GstOmxH264Dec *self;
 
+    omx_base_filter = GST_OMX_BASE_FILTER (instance);
     omx_base = GST_OMX_BASE_VIDEODEC (instance);
+    self = GST_OMX_H264DEC (instance);
 
     omx_base->compression_format = OMX_VIDEO_CodingAVC;
+
+    self->base_setcaps = GST_PAD_SETCAPSFUNC (omx_base_filter->sinkpad);
+    gst_pad_set_setcaps_function (omx_base_filter->sinkpad, sink_setcaps);
+
+    self->base_chain = GST_PAD_CHAINFUNC (omx_base_filter->sinkpad);
+    gst_pad_set_chain_function (omx_base_filter->sinkpad, pad_chain);
 }
 
 GType
@@ -37,6 +37,11 @@ typedef struct GstOmxH264DecClass GstOmxH264DecClass;
 struct GstOmxH264Dec
 {
     GstOmxBaseVideoDec omx_base;
+
+    GstPadSetCapsFunction base_setcaps;
+    GstPadChainFunction base_chain;
+    guint nal_length_size; /**< Of avcC input with prefixes shorter than start codes; 0 otherwise */
+    guint nal_pos; /**< Where in_copy resumes in the current input buffer */
 };
 
 struct GstOmxH264DecClass
@@ -26,6 +26,39 @@
 
 static GstOmxBaseFilterClass *parent_class;
 
+static const GEnumValue profiles[] = {
+    {0, "Component default", "default"},
+    {OMX_VIDEO_AVCProfileBaseline, "Baseline profile", "baseline"},
+    {OMX_VIDEO_AVCProfileMain, "Main profile", "main"},
+    {OMX_VIDEO_AVCProfileExtended, "Extended profile", "extended"},
+    {OMX_VIDEO_AVCProfileHigh, "High profile", "high"},
+    {OMX_VIDEO_AVCProfileHigh10, "High 10 profile", "high-10"},
+    {OMX_VIDEO_AVCProfileHigh422, "High 4:2:2 profile", "high-422"},
+    {OMX_VIDEO_AVCProfileHigh444, "High 4:4:4 profile", "high-444"},
+    {0, NULL, NULL},
+};
+
+static const GEnumValue levels[] = {
+    {0, "Component default", "default"},
+    {OMX_VIDEO_AVCLevel1, "Level 1", "1"},
+    {OMX_VIDEO_AVCLevel1b, "Level 1b", "1b"},
+    {OMX_VIDEO_AVCLevel11, "Level 1.1", "11"},
+    {OMX_VIDEO_AVCLevel12, "Level 1.2", "12"},
+    {OMX_VIDEO_AVCLevel13, "Level 1.3", "13"},
+    {OMX_VIDEO_AVCLevel2, "Level 2", "2"},
+    {OMX_VIDEO_AVCLevel21, "Level 2.1", "21"},
+    {OMX_VIDEO_AVCLevel22, "Level 2.2", "22"},
+    {OMX_VIDEO_AVCLevel3, "Level 3", "3"},
+    {OMX_VIDEO_AVCLevel31, "Level 3.1", "31"},
+    {OMX_VIDEO_AVCLevel32, "Level 3.2", "32"},
+    {OMX_VIDEO_AVCLevel4, "Level 4", "4"},
+    {OMX_VIDEO_AVCLevel41, "Level 4.1", "41"},
+    {OMX_VIDEO_AVCLevel42, "Level 4.2", "42"},
+    {OMX_VIDEO_AVCLevel5, "Level 5", "5"},
+    {OMX_VIDEO_AVCLevel51, "Level 5.1", "51"},
+    {0, NULL, NULL},
+};
+
 static GstCaps *
 generate_src_template (void)
 {
@@ -74,6 +107,9 @@ type_class_init (gpointer g_class,
                  gpointer class_data)
 {
     parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+
+    gst_omx_base_videoenc_class_add_profiles (GST_OMX_BASE_VIDEOENC_CLASS (g_class),
+                                              profiles, levels);
 }
 
 static void
@@ -32,16 +32,16 @@ G_BEGIN_DECLS
 typedef struct GstOmxIlbcDec GstOmxIlbcDec;
 typedef struct GstOmxIlbcDecClass GstOmxIlbcDecClass;
 
-#include "gstomx_base_filter.h"
+#include "gstomx_base_audiodec.h"
 
 struct GstOmxIlbcDec
 {
-    GstOmxBaseFilter omx_base;
+    GstOmxBaseAudioDec omx_base;
 };
 
 struct GstOmxIlbcDecClass
 {
-    GstOmxBaseFilterClass parent_class;
+    GstOmxBaseAudioDecClass parent_class;
 };
 
 GType gst_omx_ilbcdec_get_type (void);
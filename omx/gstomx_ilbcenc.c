@@ -20,10 +20,9 @@
  */
 
 #include "gstomx_ilbcenc.h"
-#include "gstomx_base_filter.h"
 #include "gstomx.h"
 
-static GstOmxBaseFilterClass *parent_class;
+static GstOmxBaseAudioEncClass *parent_class;
 
 static GstCaps *
 generate_src_template (void)
@@ -122,7 +121,7 @@ static void
 type_class_init (gpointer g_class,
                  gpointer class_data)
 {
-    parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+    parent_class = g_type_class_ref (GST_OMX_BASE_AUDIOENC_TYPE);
 }
 
 static gboolean
@@ -147,8 +146,14 @@ sink_setcaps (GstPad *pad,
 
         if (gst_caps_is_fixed (tmp_caps))
         {
+            gint mode;
+
             GST_INFO_OBJECT (omx_base, "fixated to: %" GST_PTR_FORMAT, tmp_caps);
             gst_pad_set_caps (omx_base->srcpad, tmp_caps);
+
+            /* the mode is the frame length in ms */
+            if (gst_structure_get_int (gst_caps_get_structure (tmp_caps, 0), "mode", &mode))
+                GST_OMX_BASE_AUDIOENC (omx_base)->frame_duration = mode * GST_MSECOND;
         }
 
         gst_caps_unref (tmp_caps);
@@ -166,6 +171,9 @@ type_instance_init (GTypeInstance *instance,
     omx_base = GST_OMX_BASE_FILTER (instance);
 
     gst_pad_set_setcaps_function (omx_base->sinkpad, sink_setcaps);
+
+    /* until the mode is negotiated */
+    GST_OMX_BASE_AUDIOENC (instance)->frame_duration = 20 * GST_MSECOND;
 }
 
 GType
@@ -184,7 +192,7 @@ gst_omx_ilbcenc_get_type (void)
         type_info->instance_size = sizeof (GstOmxIlbcEnc);
         type_info->instance_init = type_instance_init;
 
-        type = g_type_register_static (GST_OMX_BASE_FILTER_TYPE, "GstOmxIlbcEnc", type_info, 0);
+        type = g_type_register_static (GST_OMX_BASE_AUDIOENC_TYPE, "GstOmxIlbcEnc", type_info, 0);
 
         g_free (type_info);
     }
@@ -32,16 +32,16 @@ G_BEGIN_DECLS
 typedef struct GstOmxIlbcEnc GstOmxIlbcEnc;
 typedef struct GstOmxIlbcEncClass GstOmxIlbcEncClass;
 
-#include "gstomx_base_filter.h"
+#include "gstomx_base_audioenc.h"
 
 struct GstOmxIlbcEnc
 {
-    GstOmxBaseFilter omx_base;
+    GstOmxBaseAudioEnc omx_base;
 };
 
 struct GstOmxIlbcEncClass
 {
-    GstOmxBaseFilterClass parent_class;
+    GstOmxBaseAudioEncClass parent_class;
 };
 
 GType gst_omx_ilbcenc_get_type (void);
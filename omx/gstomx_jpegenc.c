@@ -30,9 +30,13 @@ enum
 {
     ARG_0,
     ARG_QUALITY,
+    ARG_STREAMING,
+    ARG_STRIP_HEIGHT,
 };
 
 #define DEFAULT_QUALITY 90
+#define DEFAULT_STREAMING FALSE
+#define DEFAULT_STRIP_HEIGHT 0
 
 static GstOmxBaseFilterClass *parent_class;
 
@@ -141,6 +145,14 @@ set_property (GObject *obj,
     {
         case ARG_QUALITY:
             self->quality = g_value_get_uint (value);
+            g_atomic_int_set (&self->quality_changed, TRUE);
+            break;
+        case ARG_STREAMING:
+            self->streaming = g_value_get_boolean (value);
+            GST_OMX_BASE_FILTER (self)->image_eos = self->streaming;
+            break;
+        case ARG_STRIP_HEIGHT:
+            self->strip_height = g_value_get_uint (value);
             break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
@@ -163,6 +175,12 @@ get_property (GObject *obj,
         case ARG_QUALITY:
             g_value_set_uint (value, self->quality);
             break;
+        case ARG_STREAMING:
+            g_value_set_boolean (value, self->streaming);
+            break;
+        case ARG_STRIP_HEIGHT:
+            g_value_set_uint (value, self->strip_height);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -188,6 +206,16 @@ type_class_init (gpointer g_class,
                                          g_param_spec_uint ("quality", "Quality of image",
                                                             "Set the quality from 0 to 100",
                                                             0, 100, DEFAULT_QUALITY, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_STREAMING,
+                                         g_param_spec_boolean ("streaming", "Streaming",
+                                                               "Encode a continuous stream of frames (MJPEG), keeping the component running",
+                                                               DEFAULT_STREAMING, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_STRIP_HEIGHT,
+                                         g_param_spec_uint ("strip-height", "Strip height",
+                                                            "Send the image in bands of this many lines, rounded up to 16 (0 = whole image)",
+                                                            0, 4096, DEFAULT_STRIP_HEIGHT, G_PARAM_READWRITE));
     }
 }
 
@@ -204,6 +232,10 @@ settings_changed_cb (GOmxCore *core)
 
     GST_DEBUG_OBJECT (omx_base, "settings changed");
 
+    /* all the frames have the same size */
+    if (self->streaming && GST_PAD_CAPS (omx_base->srcpad))
+        return;
+
     {
         OMX_PARAM_PORTDEFINITIONTYPE param;
 
@@ -234,6 +266,74 @@ settings_changed_cb (GOmxCore *core)
     }
 }
 
+/* I420 planes are reordered so each band of lines is contiguous:
+ * Y rows, then the U and V rows that go with them. */
+static void
+in_copy (GstOmxBaseFilter *omx_base,
+         guint8 *dest,
+         GstBuffer *buf,
+         guint offset,
+         guint size)
+{
+    GstOmxJpegEnc *self;
+    const guint8 *src_y;
+    const guint8 *src_u;
+    const guint8 *src_v;
+    guint y_stride;
+    guint uv_stride;
+    guint height;
+    guint row;
+    guint pos = 0;
+
+    self = GST_OMX_JPEGENC (omx_base);
+
+    y_stride = GST_ROUND_UP_4 (self->width);
+    uv_stride = GST_ROUND_UP_4 (GST_ROUND_UP_2 (self->width) / 2);
+    height = GST_ROUND_UP_2 (self->height);
+
+    src_y = GST_BUFFER_DATA (buf);
+    src_u = src_y + y_stride * height;
+    src_v = src_u + uv_stride * (height / 2);
+
+    for (row = 0; row < height && size > 0; row += self->strip_rows)
+    {
+        const guint8 *chunk_data[3];
+        guint chunk_size[3];
+        guint rows;
+        guint i;
+
+        rows = MIN (self->strip_rows, height - row);
+
+        chunk_data[0] = src_y + row * y_stride;
+        chunk_size[0] = rows * y_stride;
+        chunk_data[1] = src_u + (row / 2) * uv_stride;
+        chunk_size[1] = (rows / 2) * uv_stride;
+        chunk_data[2] = src_v + (row / 2) * uv_stride;
+        chunk_size[2] = (rows / 2) * uv_stride;
+
+        for (i = 0; i < 3 && size > 0; i++)
+        {
+            guint skip;
+            guint len;
+
+            if (offset >= pos + chunk_size[i])
+            {
+                pos += chunk_size[i];
+                continue;
+            }
+
+            skip = offset - pos;
+            len = MIN (chunk_size[i] - skip, size);
+            memcpy (dest, chunk_data[i] + skip, len);
+
+            dest += len;
+            offset += len;
+            size -= len;
+            pos += chunk_size[i];
+        }
+    }
+}
+
 static gboolean
 sink_setcaps (GstPad *pad,
               GstCaps *caps)
@@ -302,6 +402,46 @@ sink_setcaps (GstPad *pad,
             param.format.image.nFrameHeight = height;
             param.format.image.eColorFormat = color_format;
 
+            if (self->strip_height > 0)
+            {
+                guint strip_rows;
+                guint strip_size;
+
+                /* whole MCU rows */
+                strip_rows = GST_ROUND_UP_16 (self->strip_height);
+
+                if (color_format == OMX_COLOR_FormatYUV420Planar)
+                {
+                    param.format.image.nStride = GST_ROUND_UP_4 (width);
+                    strip_size = param.format.image.nStride * strip_rows +
+                        GST_ROUND_UP_4 (GST_ROUND_UP_2 (width) / 2) * strip_rows;
+                }
+                else
+                {
+                    param.format.image.nStride = GST_ROUND_UP_4 (width * 2);
+                    strip_size = param.format.image.nStride * strip_rows;
+                }
+
+                param.format.image.nSliceHeight = strip_rows;
+                param.nBufferSize = strip_size;
+
+                GST_INFO_OBJECT (self, "strips of %u lines, %u bytes", strip_rows, strip_size);
+
+                self->width = width;
+                self->height = height;
+                self->strip_rows = strip_rows;
+
+                omx_base->in_slice_size = strip_size;
+                omx_base->in_copy = color_format == OMX_COLOR_FormatYUV420Planar ? in_copy : NULL;
+                omx_base->frame_aligned_input = TRUE;
+            }
+            else
+            {
+                omx_base->in_slice_size = 0;
+                omx_base->in_copy = NULL;
+                omx_base->frame_aligned_input = FALSE;
+            }
+
             OMX_SetParameter (gomx->omx_handle, OMX_IndexParamPortDefinition, &param);
         }
     }
@@ -309,6 +449,53 @@ sink_setcaps (GstPad *pad,
     return gst_pad_set_caps (pad, caps);
 }
 
+static void
+setup_quality (GstOmxJpegEnc *self,
+               gboolean running)
+{
+    GOmxCore *gomx;
+    OMX_IMAGE_PARAM_QFACTORTYPE param;
+    OMX_ERRORTYPE error;
+
+    gomx = (GOmxCore *) GST_OMX_BASE_FILTER (self)->gomx;
+
+    memset (&param, 0, sizeof (param));
+    param.nSize = sizeof (OMX_IMAGE_PARAM_QFACTORTYPE);
+    param.nVersion.s.nVersionMajor = 1;
+    param.nVersion.s.nVersionMinor = 1;
+
+    param.nQFactor = self->quality;
+    param.nPortIndex = 1;
+
+    /* parameters can't change while executing, but most components take
+     * the quality as a config */
+    if (running)
+    {
+        error = OMX_SetConfig (gomx->omx_handle, OMX_IndexParamQFactor, &param);
+        if (error == OMX_ErrorNone)
+            return;
+    }
+
+    error = OMX_SetParameter (gomx->omx_handle, OMX_IndexParamQFactor, &param);
+    if (error != OMX_ErrorNone)
+        GST_WARNING_OBJECT (self, "couldn't set quality %u: 0x%x", self->quality, error);
+}
+
+static void
+prepare_input (GstOmxBaseFilter *omx_base,
+               GstBuffer *buf)
+{
+    GstOmxJpegEnc *self;
+
+    self = GST_OMX_JPEGENC (omx_base);
+
+    if (g_atomic_int_compare_and_exchange (&self->quality_changed, TRUE, FALSE))
+    {
+        GST_INFO_OBJECT (self, "quality: %u", self->quality);
+        setup_quality (self, TRUE);
+    }
+}
+
 static void
 omx_setup (GstOmxBaseFilter *omx_base)
 {
@@ -339,19 +526,8 @@ omx_setup (GstOmxBaseFilter *omx_base)
         }
     }
 
-    {
-        OMX_IMAGE_PARAM_QFACTORTYPE param;
-
-        memset (&param, 0, sizeof (param));
-        param.nSize = sizeof (OMX_IMAGE_PARAM_QFACTORTYPE);
-        param.nVersion.s.nVersionMajor = 1;
-        param.nVersion.s.nVersionMinor = 1;
-
-        param.nQFactor = self->quality;
-        param.nPortIndex = 1;
-
-        OMX_SetParameter (gomx->omx_handle, OMX_IndexParamQFactor, &param);
-    }
+    g_atomic_int_set (&self->quality_changed, FALSE);
+    setup_quality (self, FALSE);
 
     GST_INFO_OBJECT (omx_base, "end");
 }
@@ -367,6 +543,7 @@ type_instance_init (GTypeInstance *instance,
     self = GST_OMX_JPEGENC (instance);
 
     omx_base->omx_setup = omx_setup;
+    omx_base->prepare_input = prepare_input;
 
     omx_base->gomx->settings_changed_cb = settings_changed_cb;
 
@@ -375,6 +552,8 @@ type_instance_init (GTypeInstance *instance,
     self->framerate_num = 0;
     self->framerate_denom = 1;
     self->quality = DEFAULT_QUALITY;
+    self->streaming = DEFAULT_STREAMING;
+    self->strip_height = DEFAULT_STRIP_HEIGHT;
 }
 
 GType
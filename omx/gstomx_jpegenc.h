@@ -43,6 +43,14 @@ struct GstOmxJpegEnc
     gint framerate_num;
     gint framerate_denom;
     guint quality;
+    gint quality_changed; /**< Apply before the next frame */
+    gboolean streaming;
+
+    /* Strip mode; the image is sent in bands of strip_rows lines. */
+    guint strip_height;
+    guint strip_rows; /**< strip_height rounded up to whole MCU rows */
+    guint width;
+    guint height;
 };
 
 struct GstOmxJpegEncClass
@@ -24,6 +24,39 @@
 
 static GstOmxBaseVideoDecClass *parent_class;
 
+static const GstOmxVideoName profiles[] =
+{
+    { OMX_VIDEO_MPEG4ProfileSimple, "simple" },
+    { OMX_VIDEO_MPEG4ProfileSimpleScalable, "simple-scalable" },
+    { OMX_VIDEO_MPEG4ProfileCore, "core" },
+    { OMX_VIDEO_MPEG4ProfileMain, "main" },
+    { OMX_VIDEO_MPEG4ProfileNbit, "n-bit" },
+    { OMX_VIDEO_MPEG4ProfileScalableTexture, "scalable" },
+    { OMX_VIDEO_MPEG4ProfileSimpleFace, "simple-face" },
+    { OMX_VIDEO_MPEG4ProfileSimpleFBA, "simple-fba" },
+    { OMX_VIDEO_MPEG4ProfileBasicAnimated, "basic-animated-texture" },
+    { OMX_VIDEO_MPEG4ProfileHybrid, "hybrid" },
+    { OMX_VIDEO_MPEG4ProfileAdvancedRealTime, "advanced-real-time-simple" },
+    { OMX_VIDEO_MPEG4ProfileCoreScalable, "core-scalable" },
+    { OMX_VIDEO_MPEG4ProfileAdvancedCoding, "advanced-coding-efficiency" },
+    { OMX_VIDEO_MPEG4ProfileAdvancedCore, "advanced-core" },
+    { OMX_VIDEO_MPEG4ProfileAdvancedScalable, "advanced-scalable-texture" },
+    { 0, NULL },
+};
+
+static const GstOmxVideoName levels[] =
+{
+    { OMX_VIDEO_MPEG4Level0, "0" },
+    { OMX_VIDEO_MPEG4Level0b, "0b" },
+    { OMX_VIDEO_MPEG4Level1, "1" },
+    { OMX_VIDEO_MPEG4Level2, "2" },
+    { OMX_VIDEO_MPEG4Level3, "3" },
+    { OMX_VIDEO_MPEG4Level4, "4" },
+    { OMX_VIDEO_MPEG4Level4a, "4a" },
+    { OMX_VIDEO_MPEG4Level5, "5" },
+    { 0, NULL },
+};
+
 static GstCaps *
 generate_sink_template (void)
 {
@@ -93,7 +126,9 @@ type_base_init (gpointer g_class)
 
         template = gst_pad_template_new ("sink", GST_PAD_SINK,
                                          GST_PAD_ALWAYS,
-                                         generate_sink_template ());
+                                         gst_omx_base_videodec_probe_sink_caps (g_class,
+                                                                                generate_sink_template (),
+                                                                                profiles, levels));
 
         gst_element_class_add_pad_template (element_class, template);
     }
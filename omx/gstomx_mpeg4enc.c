@@ -26,6 +26,31 @@
 
 static GstOmxBaseFilterClass *parent_class;
 
+static const GEnumValue profiles[] = {
+    {0, "Component default", "default"},
+    {OMX_VIDEO_MPEG4ProfileSimple, "Simple profile", "simple"},
+    {OMX_VIDEO_MPEG4ProfileSimpleScalable, "Simple scalable profile", "simple-scalable"},
+    {OMX_VIDEO_MPEG4ProfileCore, "Core profile", "core"},
+    {OMX_VIDEO_MPEG4ProfileMain, "Main profile", "main"},
+    {OMX_VIDEO_MPEG4ProfileAdvancedRealTime, "Advanced real time simple profile", "advanced-real-time"},
+    {OMX_VIDEO_MPEG4ProfileAdvancedCoding, "Advanced coding efficiency profile", "advanced-coding"},
+    {OMX_VIDEO_MPEG4ProfileAdvancedCore, "Advanced core profile", "advanced-core"},
+    {0, NULL, NULL},
+};
+
+static const GEnumValue levels[] = {
+    {0, "Component default", "default"},
+    {OMX_VIDEO_MPEG4Level0, "Level 0", "0"},
+    {OMX_VIDEO_MPEG4Level0b, "Level 0b", "0b"},
+    {OMX_VIDEO_MPEG4Level1, "Level 1", "1"},
+    {OMX_VIDEO_MPEG4Level2, "Level 2", "2"},
+    {OMX_VIDEO_MPEG4Level3, "Level 3", "3"},
+    {OMX_VIDEO_MPEG4Level4, "Level 4", "4"},
+    {OMX_VIDEO_MPEG4Level4a, "Level 4a", "4a"},
+    {OMX_VIDEO_MPEG4Level5, "Level 5", "5"},
+    {0, NULL, NULL},
+};
+
 static GstCaps *
 generate_src_template (void)
 {
@@ -76,6 +101,9 @@ type_class_init (gpointer g_class,
                  gpointer class_data)
 {
     parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+
+    gst_omx_base_videoenc_class_add_profiles (GST_OMX_BASE_VIDEOENC_CLASS (g_class),
+                                              profiles, levels);
 }
 
 static void
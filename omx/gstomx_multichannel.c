@@ -0,0 +1,1108 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gstomx_multichannel.h"
+#include "gstomx.h"
+
+#include <stdio.h> /* for sscanf */
+#include <string.h> /* for memset, memcpy, strcmp */
+
+enum
+{
+    ARG_0,
+    ARG_COMPONENT_NAME,
+    ARG_LIBRARY_NAME,
+    ARG_SRC_CAPS,
+    ARG_POOL_SIZE,
+};
+
+#define DEFAULT_POOL_SIZE 8
+
+static GstElementClass *parent_class;
+
+static GstCaps *
+generate_src_template (void)
+{
+    GstCaps *caps;
+
+    caps = gst_caps_new_any ();
+
+    return caps;
+}
+
+static GstCaps *
+generate_sink_template (void)
+{
+    GstCaps *caps;
+
+    caps = gst_caps_new_any ();
+
+    return caps;
+}
+
+/*
+ * Component pool
+ */
+
+static void
+wake_scheduler (GstOmxMultiChannel *self)
+{
+    g_mutex_lock (self->lock);
+    self->pending++;
+    g_cond_signal (self->cond);
+    g_mutex_unlock (self->lock);
+}
+
+/* From the component's thread; the scheduler does the work. */
+static void
+out_buffer_cb (GOmxPort *port)
+{
+    wake_scheduler (port->core->object);
+}
+
+static GOmxCore *
+pool_get (GstOmxMultiChannel *self)
+{
+    GOmxCore *core;
+
+    g_mutex_lock (self->lock);
+    core = g_queue_pop_head (self->pool);
+    g_mutex_unlock (self->lock);
+
+    if (core)
+        return core;
+
+    core = g_omx_core_new ();
+    core->object = self;
+    core->out_buffer_cb = out_buffer_cb;
+
+    g_omx_core_init (core, self->omx_library, self->omx_component);
+
+    if (core->omx_state != OMX_StateLoaded)
+    {
+        g_omx_core_deinit (core);
+        g_omx_core_free (core);
+        return NULL;
+    }
+
+    return core;
+}
+
+static void
+pool_put (GstOmxMultiChannel *self,
+          GOmxCore *core)
+{
+    g_mutex_lock (self->lock);
+    if (g_queue_get_length (self->pool) < self->pool_size &&
+        core->omx_state == OMX_StateLoaded)
+    {
+        g_queue_push_tail (self->pool, core);
+        core = NULL;
+    }
+    g_mutex_unlock (self->lock);
+
+    if (core)
+    {
+        g_omx_core_deinit (core);
+        g_omx_core_free (core);
+    }
+}
+
+static void
+pool_clear (GstOmxMultiChannel *self)
+{
+    GOmxCore *core;
+
+    g_mutex_lock (self->lock);
+    while ((core = g_queue_pop_head (self->pool)))
+    {
+        g_omx_core_deinit (core);
+        g_omx_core_free (core);
+    }
+    g_mutex_unlock (self->lock);
+}
+
+/*
+ * Channels
+ */
+
+static void
+setup_pcm_mode (GOmxCore *core,
+                guint port_index,
+                GstCaps *caps)
+{
+    OMX_AUDIO_PARAM_PCMMODETYPE param;
+    const gchar *name;
+
+    name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+
+    memset (&param, 0, sizeof (param));
+    param.nSize = sizeof (OMX_AUDIO_PARAM_PCMMODETYPE);
+    param.nVersion.s.nVersionMajor = 1;
+    param.nVersion.s.nVersionMinor = 1;
+
+    param.nPortIndex = port_index;
+    OMX_GetParameter (core->omx_handle, OMX_IndexParamAudioPcm, &param);
+
+    if (strcmp (name, "audio/x-alaw") == 0)
+        param.ePCMMode = OMX_AUDIO_PCMModeALaw;
+    else if (strcmp (name, "audio/x-mulaw") == 0)
+        param.ePCMMode = OMX_AUDIO_PCMModeMULaw;
+    else
+        return;
+
+    OMX_SetParameter (core->omx_handle, OMX_IndexParamAudioPcm, &param);
+}
+
+/* Voice frames are small; the minimum number of buffers keeps the
+ * memory per channel down. */
+static GOmxPort *
+setup_port (GOmxCore *core,
+            guint port_index)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+
+    memset (&param, 0, sizeof (param));
+    param.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+    param.nVersion.s.nVersionMajor = 1;
+    param.nVersion.s.nVersionMinor = 1;
+
+    param.nPortIndex = port_index;
+    OMX_GetParameter (core->omx_handle, OMX_IndexParamPortDefinition, &param);
+
+    if (param.nBufferCountMin && param.nBufferCountActual > param.nBufferCountMin)
+    {
+        param.nBufferCountActual = param.nBufferCountMin;
+        OMX_SetParameter (core->omx_handle, OMX_IndexParamPortDefinition, &param);
+    }
+
+    return g_omx_core_setup_port (core, &param);
+}
+
+/* Called with the channel's ready_lock. */
+static void
+channel_start (GstOmxMultiChannel *self,
+               GstOmxChannel *channel)
+{
+    GOmxCore *core;
+
+    core = channel->gomx;
+
+    channel->in_port = setup_port (core, 0);
+    channel->out_port = setup_port (core, 1);
+
+    /* a pooled component may have left these paused */
+    g_omx_port_resume (channel->in_port);
+    g_omx_port_resume (channel->out_port);
+
+    g_omx_core_prepare (core);
+    if (core->omx_state != OMX_StateIdle)
+        return;
+
+    g_omx_core_start (core);
+    if (core->omx_state != OMX_StateExecuting)
+        return;
+
+    channel->last_pad_push_return = GST_FLOW_OK;
+    channel->ready = TRUE;
+
+    GST_INFO_OBJECT (self, "started %s", GST_PAD_NAME (channel->sinkpad));
+}
+
+/* Called with the channel's ready_lock; leaves the component loaded. */
+static void
+channel_stop (GstOmxMultiChannel *self,
+              GstOmxChannel *channel)
+{
+    GOmxCore *core;
+
+    if (!channel->ready)
+        return;
+
+    core = channel->gomx;
+
+    g_omx_port_pause (channel->in_port);
+    g_omx_port_pause (channel->out_port);
+
+    g_omx_core_stop (core);
+    g_omx_core_unload (core);
+
+    /* the headers are gone with the buffers */
+    async_queue_flush (channel->in_port->queue);
+    async_queue_flush (channel->out_port->queue);
+
+    channel->ready = FALSE;
+
+    GST_INFO_OBJECT (self, "stopped %s", GST_PAD_NAME (channel->sinkpad));
+}
+
+/*
+ * Output
+ */
+
+static void
+queue_output (GstOmxChannel *channel,
+              gpointer item)
+{
+    g_mutex_lock (channel->queue_lock);
+    if (channel->flushing)
+    {
+        gst_mini_object_unref (item);
+    }
+    else
+    {
+        g_queue_push_tail (channel->queue, item);
+        g_cond_signal (channel->queue_cond);
+    }
+    g_mutex_unlock (channel->queue_lock);
+}
+
+/* Drops what's queued; while flushing, later output is dropped too and
+ * drain_output doesn't wait. */
+static void
+flush_output (GstOmxChannel *channel,
+              gboolean flushing)
+{
+    gpointer item;
+
+    g_mutex_lock (channel->queue_lock);
+    channel->flushing = flushing;
+    while ((item = g_queue_pop_head (channel->queue)))
+        gst_mini_object_unref (item);
+    g_cond_broadcast (channel->queue_cond);
+    g_mutex_unlock (channel->queue_lock);
+}
+
+/* From the channel's streaming thread, with nothing held, so a blocked
+ * peer only holds up its own channel. Returns TRUE once the EOS went
+ * out. */
+static gboolean
+push_output (GstOmxMultiChannel *self,
+             GstOmxChannel *channel)
+{
+    gpointer item;
+    gboolean eos = FALSE;
+
+    g_mutex_lock (channel->queue_lock);
+    while (!eos && (item = g_queue_pop_head (channel->queue)))
+    {
+        g_mutex_unlock (channel->queue_lock);
+
+        if (GST_IS_EVENT (item))
+        {
+            GST_INFO_OBJECT (self, "%s: eos", GST_PAD_NAME (channel->srcpad));
+            gst_pad_push_event (channel->srcpad, item);
+            eos = TRUE;
+        }
+        else
+        {
+            GstFlowReturn ret;
+
+            ret = gst_pad_push (channel->srcpad, item);
+            if (ret != GST_FLOW_OK)
+                GST_DEBUG_OBJECT (self, "%s: %s", GST_PAD_NAME (channel->srcpad),
+                                  gst_flow_get_name (ret));
+            channel->last_pad_push_return = ret;
+        }
+
+        g_mutex_lock (channel->queue_lock);
+    }
+    g_mutex_unlock (channel->queue_lock);
+
+    return eos;
+}
+
+/* Pushes the output left after the EOS buffer, then the EOS itself;
+ * FALSE when a flush or a state change came first. */
+static gboolean
+drain_output (GstOmxMultiChannel *self,
+              GstOmxChannel *channel)
+{
+    g_mutex_lock (channel->queue_lock);
+    while (!channel->flushing)
+    {
+        if (g_queue_is_empty (channel->queue))
+        {
+            g_cond_wait (channel->queue_cond, channel->queue_lock);
+            continue;
+        }
+
+        g_mutex_unlock (channel->queue_lock);
+
+        if (push_output (self, channel))
+            return TRUE;
+
+        g_mutex_lock (channel->queue_lock);
+    }
+    g_mutex_unlock (channel->queue_lock);
+
+    return FALSE;
+}
+
+/*
+ * Scheduler
+ */
+
+/* Only moves the output to the channel's queue; never blocks. */
+static void
+service_channel (GstOmxMultiChannel *self,
+                 GstOmxChannel *channel)
+{
+    OMX_BUFFERHEADERTYPE *omx_buffer;
+
+    /* being started or stopped; pad_chain wakes us once it has started */
+    if (!g_mutex_trylock (channel->ready_lock))
+        return;
+
+    while (channel->ready &&
+           (omx_buffer = async_queue_pop_forced (channel->out_port->queue)))
+    {
+        gboolean eos;
+
+        eos = (omx_buffer->nFlags & OMX_BUFFERFLAG_EOS) != 0;
+
+        if (omx_buffer->nFilledLen > 0)
+        {
+            GstBuffer *buf;
+
+            buf = gst_buffer_new_and_alloc (omx_buffer->nFilledLen);
+            memcpy (GST_BUFFER_DATA (buf), omx_buffer->pBuffer + omx_buffer->nOffset,
+                    omx_buffer->nFilledLen);
+
+            GST_BUFFER_TIMESTAMP (buf) = gst_util_uint64_scale_int (omx_buffer->nTimeStamp,
+                                                                    GST_SECOND,
+                                                                    OMX_TICKS_PER_SECOND);
+
+            if (GST_PAD_CAPS (channel->srcpad))
+                gst_buffer_set_caps (buf, GST_PAD_CAPS (channel->srcpad));
+
+            queue_output (channel, buf);
+        }
+
+        omx_buffer->nFilledLen = 0;
+        g_omx_port_release_buffer (channel->out_port, omx_buffer);
+
+        if (eos)
+            queue_output (channel, gst_event_new_eos ());
+    }
+
+    g_mutex_unlock (channel->ready_lock);
+}
+
+static gpointer
+scheduler_thread (gpointer data)
+{
+    GstOmxMultiChannel *self;
+
+    self = GST_OMX_MULTICHANNEL (data);
+
+    GST_LOG_OBJECT (self, "begin");
+
+    g_mutex_lock (self->lock);
+
+    while (self->running)
+    {
+        GList *channels;
+        GList *cur;
+
+        if (self->pending == 0)
+        {
+            g_cond_wait (self->cond, self->lock);
+            continue;
+        }
+
+        /* release_pad takes service_lock first, then lock */
+        g_mutex_unlock (self->lock);
+        g_mutex_lock (self->service_lock);
+        g_mutex_lock (self->lock);
+
+        self->pending = 0;
+        channels = g_list_copy (self->channels);
+
+        g_mutex_unlock (self->lock);
+
+        for (cur = channels; cur; cur = cur->next)
+            service_channel (self, cur->data);
+
+        g_list_free (channels);
+        g_mutex_unlock (self->service_lock);
+
+        g_mutex_lock (self->lock);
+    }
+
+    g_mutex_unlock (self->lock);
+
+    GST_LOG_OBJECT (self, "end");
+
+    return NULL;
+}
+
+static void
+scheduler_start (GstOmxMultiChannel *self)
+{
+    g_mutex_lock (self->lock);
+    self->running = TRUE;
+    self->pending = 0;
+    g_mutex_unlock (self->lock);
+
+    self->thread = g_thread_create (scheduler_thread, self, TRUE, NULL);
+}
+
+static void
+scheduler_stop (GstOmxMultiChannel *self)
+{
+    if (!self->thread)
+        return;
+
+    g_mutex_lock (self->lock);
+    self->running = FALSE;
+    g_cond_signal (self->cond);
+    g_mutex_unlock (self->lock);
+
+    g_thread_join (self->thread);
+    self->thread = NULL;
+}
+
+/*
+ * Pads
+ */
+
+static gboolean
+sink_setcaps (GstPad *pad,
+              GstCaps *caps)
+{
+    GstOmxChannel *channel;
+    GstOmxMultiChannel *self;
+
+    channel = gst_pad_get_element_private (pad);
+    self = channel->parent;
+
+    GST_INFO_OBJECT (self, "setcaps (%s): %" GST_PTR_FORMAT, GST_PAD_NAME (pad), caps);
+
+    g_mutex_lock (channel->ready_lock);
+    if (!channel->ready)
+    {
+        setup_pcm_mode (channel->gomx, 0, caps);
+        if (self->src_caps)
+            setup_pcm_mode (channel->gomx, 1, self->src_caps);
+    }
+    else
+    {
+        GST_WARNING_OBJECT (self, "%s: caps changed while running", GST_PAD_NAME (pad));
+    }
+    g_mutex_unlock (channel->ready_lock);
+
+    return TRUE;
+}
+
+static GstFlowReturn
+pad_chain (GstPad *pad,
+           GstBuffer *buf)
+{
+    GstOmxChannel *channel;
+    GstOmxMultiChannel *self;
+    GstFlowReturn ret = GST_FLOW_OK;
+    guint buffer_offset = 0;
+
+    channel = gst_pad_get_element_private (pad);
+    self = channel->parent;
+
+    if (G_UNLIKELY (!channel->ready))
+    {
+        g_mutex_lock (channel->ready_lock);
+        if (!channel->ready)
+            channel_start (self, channel);
+        g_mutex_unlock (channel->ready_lock);
+
+        if (!channel->ready)
+        {
+            GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+                               ("Unable to start the component for %s", GST_PAD_NAME (pad)));
+            gst_buffer_unref (buf);
+            return GST_FLOW_ERROR;
+        }
+
+        /* in case output came back while the lock was held */
+        wake_scheduler (self);
+    }
+
+    /* what came out of the previous buffers */
+    push_output (self, channel);
+
+    while (buffer_offset < GST_BUFFER_SIZE (buf))
+    {
+        OMX_BUFFERHEADERTYPE *omx_buffer;
+
+        if (channel->last_pad_push_return != GST_FLOW_OK)
+        {
+            ret = channel->last_pad_push_return;
+            break;
+        }
+
+        omx_buffer = g_omx_port_request_buffer (channel->in_port);
+
+        if (G_UNLIKELY (!omx_buffer))
+        {
+            ret = GST_FLOW_WRONG_STATE;
+            break;
+        }
+
+        omx_buffer->nFilledLen = MIN (GST_BUFFER_SIZE (buf) - buffer_offset,
+                                      omx_buffer->nAllocLen - omx_buffer->nOffset);
+        memcpy (omx_buffer->pBuffer + omx_buffer->nOffset, GST_BUFFER_DATA (buf) + buffer_offset,
+                omx_buffer->nFilledLen);
+
+        if (GST_BUFFER_TIMESTAMP_IS_VALID (buf))
+        {
+            omx_buffer->nTimeStamp = gst_util_uint64_scale_int (GST_BUFFER_TIMESTAMP (buf),
+                                                                OMX_TICKS_PER_SECOND,
+                                                                GST_SECOND);
+        }
+
+        omx_buffer->nFlags = 0;
+        buffer_offset += omx_buffer->nFilledLen;
+
+        g_omx_port_release_buffer (channel->in_port, omx_buffer);
+    }
+
+    gst_buffer_unref (buf);
+
+    if (ret == GST_FLOW_OK)
+    {
+        push_output (self, channel);
+        ret = channel->last_pad_push_return;
+    }
+
+    return ret;
+}
+
+static gboolean
+pad_event (GstPad *pad,
+           GstEvent *event)
+{
+    GstOmxChannel *channel;
+    GstOmxMultiChannel *self;
+
+    channel = gst_pad_get_element_private (pad);
+    self = channel->parent;
+
+    GST_INFO_OBJECT (self, "event (%s): %s", GST_PAD_NAME (pad), GST_EVENT_TYPE_NAME (event));
+
+    switch (GST_EVENT_TYPE (event))
+    {
+        case GST_EVENT_EOS:
+            /* the scheduler queues one once the component is drained */
+            if (channel->ready && channel->last_pad_push_return == GST_FLOW_OK)
+            {
+                OMX_BUFFERHEADERTYPE *omx_buffer;
+
+                omx_buffer = g_omx_port_request_buffer (channel->in_port);
+
+                if (G_LIKELY (omx_buffer))
+                {
+                    omx_buffer->nFilledLen = 0;
+                    omx_buffer->nFlags = OMX_BUFFERFLAG_EOS;
+                    g_omx_port_release_buffer (channel->in_port, omx_buffer);
+                    gst_event_unref (event);
+
+                    if (!drain_output (self, channel))
+                        GST_DEBUG_OBJECT (self, "%s: flushed before eos", GST_PAD_NAME (pad));
+
+                    return TRUE;
+                }
+            }
+            break;
+
+        case GST_EVENT_FLUSH_START:
+            channel->last_pad_push_return = GST_FLOW_WRONG_STATE;
+            flush_output (channel, TRUE);
+            if (channel->ready)
+                g_omx_core_flush_start (channel->gomx);
+            break;
+
+        case GST_EVENT_FLUSH_STOP:
+            if (channel->ready)
+                g_omx_core_flush_stop (channel->gomx);
+            flush_output (channel, FALSE);
+            channel->last_pad_push_return = GST_FLOW_OK;
+            break;
+
+        default:
+            break;
+    }
+
+    /* keep the output of earlier buffers ahead of the event */
+    if (GST_EVENT_IS_SERIALIZED (event))
+        push_output (self, channel);
+
+    return gst_pad_push_event (channel->srcpad, event);
+}
+
+static GstPad *
+request_new_pad (GstElement *element,
+                 GstPadTemplate *templ,
+                 const gchar *name)
+{
+    GstOmxMultiChannel *self;
+    GstElementClass *element_class;
+    GstOmxChannel *channel;
+    GOmxCore *core;
+    guint index;
+
+    self = GST_OMX_MULTICHANNEL (element);
+    element_class = GST_ELEMENT_GET_CLASS (element);
+
+    if (templ != gst_element_class_get_pad_template (element_class, "sink_%d"))
+        return NULL;
+
+    core = pool_get (self);
+    if (!core)
+    {
+        GST_WARNING_OBJECT (self, "no component for a new channel");
+        return NULL;
+    }
+
+    channel = g_new0 (GstOmxChannel, 1);
+    channel->parent = self;
+    channel->gomx = core;
+    channel->ready_lock = g_mutex_new ();
+    channel->last_pad_push_return = GST_FLOW_OK;
+    channel->queue_lock = g_mutex_new ();
+    channel->queue_cond = g_cond_new ();
+    channel->queue = g_queue_new ();
+
+    g_mutex_lock (self->lock);
+    if (name && sscanf (name, "sink_%u", &index) == 1)
+        self->next_pad = MAX (self->next_pad, index + 1);
+    else
+        index = self->next_pad++;
+    g_mutex_unlock (self->lock);
+
+    {
+        gchar *pad_name;
+
+        pad_name = g_strdup_printf ("sink_%u", index);
+        channel->sinkpad = gst_pad_new_from_template (templ, pad_name);
+        g_free (pad_name);
+
+        pad_name = g_strdup_printf ("src_%u", index);
+        channel->srcpad =
+            gst_pad_new_from_template (gst_element_class_get_pad_template (element_class, "src_%d"),
+                                       pad_name);
+        g_free (pad_name);
+    }
+
+    gst_pad_set_element_private (channel->sinkpad, channel);
+    gst_pad_set_element_private (channel->srcpad, channel);
+
+    gst_pad_set_chain_function (channel->sinkpad, pad_chain);
+    gst_pad_set_event_function (channel->sinkpad, pad_event);
+    gst_pad_set_setcaps_function (channel->sinkpad, sink_setcaps);
+
+    gst_pad_use_fixed_caps (channel->srcpad);
+    if (self->src_caps)
+        gst_pad_set_caps (channel->srcpad, self->src_caps);
+
+    g_mutex_lock (self->service_lock);
+    g_mutex_lock (self->lock);
+    self->channels = g_list_append (self->channels, channel);
+    g_mutex_unlock (self->lock);
+    g_mutex_unlock (self->service_lock);
+
+    if (GST_STATE (element) > GST_STATE_READY)
+    {
+        gst_pad_set_active (channel->srcpad, TRUE);
+        gst_pad_set_active (channel->sinkpad, TRUE);
+    }
+
+    gst_element_add_pad (element, channel->srcpad);
+    gst_element_add_pad (element, channel->sinkpad);
+
+    GST_INFO_OBJECT (self, "new channel: %s", GST_PAD_NAME (channel->sinkpad));
+
+    return channel->sinkpad;
+}
+
+static void
+channel_free (GstOmxChannel *channel)
+{
+    flush_output (channel, TRUE);
+    g_queue_free (channel->queue);
+    g_cond_free (channel->queue_cond);
+    g_mutex_free (channel->queue_lock);
+    g_mutex_free (channel->ready_lock);
+    g_free (channel);
+}
+
+static void
+release_pad (GstElement *element,
+             GstPad *pad)
+{
+    GstOmxMultiChannel *self;
+    GstOmxChannel *channel;
+
+    self = GST_OMX_MULTICHANNEL (element);
+    channel = gst_pad_get_element_private (pad);
+
+    GST_INFO_OBJECT (self, "releasing %s", GST_PAD_NAME (pad));
+
+    g_mutex_lock (self->service_lock);
+    g_mutex_lock (self->lock);
+    self->channels = g_list_remove (self->channels, channel);
+    g_mutex_unlock (self->lock);
+    g_mutex_unlock (self->service_lock);
+
+    /* unblock and wait for the streaming thread */
+    flush_output (channel, TRUE);
+    gst_pad_set_active (channel->srcpad, FALSE);
+    if (channel->in_port)
+        g_omx_port_pause (channel->in_port);
+    gst_pad_set_active (channel->sinkpad, FALSE);
+
+    g_mutex_lock (channel->ready_lock);
+    channel_stop (self, channel);
+    g_mutex_unlock (channel->ready_lock);
+
+    gst_element_remove_pad (element, channel->srcpad);
+    gst_element_remove_pad (element, channel->sinkpad);
+
+    pool_put (self, channel->gomx);
+    channel_free (channel);
+}
+
+/*
+ * Element
+ */
+
+static GstStateChangeReturn
+change_state (GstElement *element,
+              GstStateChange transition)
+{
+    GstStateChangeReturn ret;
+    GstOmxMultiChannel *self;
+    GList *channels;
+    GList *cur;
+
+    self = GST_OMX_MULTICHANNEL (element);
+
+    GST_INFO_OBJECT (self, "changing state %s - %s",
+                     gst_element_state_get_name (GST_STATE_TRANSITION_CURRENT (transition)),
+                     gst_element_state_get_name (GST_STATE_TRANSITION_NEXT (transition)));
+
+    g_mutex_lock (self->lock);
+    channels = g_list_copy (self->channels);
+    g_mutex_unlock (self->lock);
+
+    switch (transition)
+    {
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            for (cur = channels; cur; cur = cur->next)
+                flush_output (cur->data, FALSE);
+            scheduler_start (self);
+            break;
+
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            /* let the streaming threads go before the pads are deactivated */
+            for (cur = channels; cur; cur = cur->next)
+            {
+                GstOmxChannel *channel = cur->data;
+
+                flush_output (channel, TRUE);
+
+                if (channel->ready)
+                {
+                    g_omx_port_pause (channel->in_port);
+                    g_omx_port_pause (channel->out_port);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+    if (ret == GST_STATE_CHANGE_FAILURE)
+        goto leave;
+
+    switch (transition)
+    {
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            scheduler_stop (self);
+
+            for (cur = channels; cur; cur = cur->next)
+            {
+                GstOmxChannel *channel = cur->data;
+
+                g_mutex_lock (channel->ready_lock);
+                channel_stop (self, channel);
+                g_mutex_unlock (channel->ready_lock);
+
+                channel->last_pad_push_return = GST_FLOW_OK;
+            }
+            break;
+
+        case GST_STATE_CHANGE_READY_TO_NULL:
+            pool_clear (self);
+            break;
+
+        default:
+            break;
+    }
+
+leave:
+    g_list_free (channels);
+
+    return ret;
+}
+
+static void
+finalize (GObject *obj)
+{
+    GstOmxMultiChannel *self;
+    GList *cur;
+
+    self = GST_OMX_MULTICHANNEL (obj);
+
+    scheduler_stop (self);
+
+    /* pads that were never released */
+    for (cur = self->channels; cur; cur = cur->next)
+    {
+        GstOmxChannel *channel = cur->data;
+
+        g_omx_core_deinit (channel->gomx);
+        g_omx_core_free (channel->gomx);
+        channel_free (channel);
+    }
+    g_list_free (self->channels);
+
+    pool_clear (self);
+    g_queue_free (self->pool);
+
+    gst_caps_replace (&self->src_caps, NULL);
+
+    g_free (self->omx_component);
+    g_free (self->omx_library);
+
+    g_cond_free (self->cond);
+    g_mutex_free (self->service_lock);
+    g_mutex_free (self->lock);
+
+    G_OBJECT_CLASS (parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject *obj,
+              guint prop_id,
+              const GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxMultiChannel *self;
+
+    self = GST_OMX_MULTICHANNEL (obj);
+
+    switch (prop_id)
+    {
+        case ARG_COMPONENT_NAME:
+            pool_clear (self);
+            g_free (self->omx_component);
+            self->omx_component = g_value_dup_string (value);
+            break;
+        case ARG_LIBRARY_NAME:
+            pool_clear (self);
+            g_free (self->omx_library);
+            self->omx_library = g_value_dup_string (value);
+            break;
+        case ARG_SRC_CAPS:
+            gst_caps_replace (&self->src_caps, (GstCaps *) gst_value_get_caps (value));
+            break;
+        case ARG_POOL_SIZE:
+            g_mutex_lock (self->lock);
+            self->pool_size = g_value_get_uint (value);
+            g_mutex_unlock (self->lock);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+get_property (GObject *obj,
+              guint prop_id,
+              GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxMultiChannel *self;
+
+    self = GST_OMX_MULTICHANNEL (obj);
+
+    switch (prop_id)
+    {
+        case ARG_COMPONENT_NAME:
+            g_value_set_string (value, self->omx_component);
+            break;
+        case ARG_LIBRARY_NAME:
+            g_value_set_string (value, self->omx_library);
+            break;
+        case ARG_SRC_CAPS:
+            gst_value_set_caps (value, self->src_caps);
+            break;
+        case ARG_POOL_SIZE:
+            g_value_set_uint (value, self->pool_size);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+type_base_init (gpointer g_class)
+{
+    GstElementClass *element_class;
+
+    element_class = GST_ELEMENT_CLASS (g_class);
+
+    {
+        GstElementDetails details;
+
+        details.longname = "OpenMAX IL multi-channel filter";
+        details.klass = "Codec/Audio";
+        details.description = "Runs one OpenMAX IL component per request pad, serviced by a single thread";
+        details.author = "Felipe Contreras";
+
+        gst_element_class_set_details (element_class, &details);
+    }
+
+    {
+        GstPadTemplate *template;
+
+        template = gst_pad_template_new ("src_%d", GST_PAD_SRC,
+                                         GST_PAD_SOMETIMES,
+                                         generate_src_template ());
+
+        gst_element_class_add_pad_template (element_class, template);
+    }
+
+    {
+        GstPadTemplate *template;
+
+        template = gst_pad_template_new ("sink_%d", GST_PAD_SINK,
+                                         GST_PAD_REQUEST,
+                                         generate_sink_template ());
+
+        gst_element_class_add_pad_template (element_class, template);
+    }
+}
+
+static void
+type_class_init (gpointer g_class,
+                 gpointer class_data)
+{
+    GObjectClass *gobject_class;
+    GstElementClass *gstelement_class;
+
+    gobject_class = G_OBJECT_CLASS (g_class);
+    gstelement_class = GST_ELEMENT_CLASS (g_class);
+
+    parent_class = g_type_class_ref (GST_TYPE_ELEMENT);
+
+    gobject_class->finalize = finalize;
+    gstelement_class->change_state = change_state;
+    gstelement_class->request_new_pad = request_new_pad;
+    gstelement_class->release_pad = release_pad;
+
+    /* Properties stuff */
+    {
+        gobject_class->set_property = set_property;
+        gobject_class->get_property = get_property;
+
+        g_object_class_install_property (gobject_class, ARG_COMPONENT_NAME,
+                                         g_param_spec_string ("component-name", "Component name",
+                                                              "Name of the OpenMAX IL component to use",
+                                                              NULL, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_LIBRARY_NAME,
+                                         g_param_spec_string ("library-name", "Library name",
+                                                              "Name of the OpenMAX IL implementation library to use",
+                                                              NULL, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_SRC_CAPS,
+                                         g_param_spec_boxed ("src-caps", "Source caps",
+                                                             "Caps of the output of every channel",
+                                                             GST_TYPE_CAPS, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_POOL_SIZE,
+                                         g_param_spec_uint ("pool-size", "Pool size",
+                                                            "Released components kept loaded for new channels",
+                                                            0, 1024, DEFAULT_POOL_SIZE, G_PARAM_READWRITE));
+    }
+}
+
+static void
+type_instance_init (GTypeInstance *instance,
+                    gpointer g_class)
+{
+    GstOmxMultiChannel *self;
+
+    self = GST_OMX_MULTICHANNEL (instance);
+
+    self->lock = g_mutex_new ();
+    self->service_lock = g_mutex_new ();
+    self->cond = g_cond_new ();
+    self->pool = g_queue_new ();
+    self->pool_size = DEFAULT_POOL_SIZE;
+
+    {
+        const char *tmp;
+        tmp = g_type_get_qdata (G_OBJECT_CLASS_TYPE (g_class),
+                                g_quark_from_static_string ("library-name"));
+        self->omx_library = g_strdup (tmp);
+        tmp = g_type_get_qdata (G_OBJECT_CLASS_TYPE (g_class),
+                                g_quark_from_static_string ("component-name"));
+        self->omx_component = g_strdup (tmp);
+    }
+}
+
+GType
+gst_omx_multichannel_get_type (void)
+{
+    static GType type = 0;
+
+    if (G_UNLIKELY (type == 0))
+    {
+        GTypeInfo *type_info;
+
+        type_info = g_new0 (GTypeInfo, 1);
+        type_info->class_size = sizeof (GstOmxMultiChannelClass);
+        type_info->base_init = type_base_init;
+        type_info->class_init = type_class_init;
+        type_info->instance_size = sizeof (GstOmxMultiChannel);
+        type_info->instance_init = type_instance_init;
+
+        type = g_type_register_static (GST_TYPE_ELEMENT, "GstOmxMultiChannel", type_info, 0);
+
+        g_free (type_info);
+    }
+
+    return type;
+}
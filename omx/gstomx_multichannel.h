@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef GSTOMX_MULTICHANNEL_H
+#define GSTOMX_MULTICHANNEL_H
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_OMX_MULTICHANNEL(obj) (GstOmxMultiChannel *) (obj)
+#define GST_OMX_MULTICHANNEL_TYPE (gst_omx_multichannel_get_type ())
+
+typedef struct GstOmxMultiChannel GstOmxMultiChannel;
+typedef struct GstOmxMultiChannelClass GstOmxMultiChannelClass;
+typedef struct GstOmxChannel GstOmxChannel;
+
+#include "gstomx_util.h"
+
+/* One request sink pad, its src pad, and the component behind them. */
+struct GstOmxChannel
+{
+    GstOmxMultiChannel *parent;
+
+    GstPad *sinkpad;
+    GstPad *srcpad;
+
+    GOmxCore *gomx;
+    GOmxPort *in_port;
+    GOmxPort *out_port;
+
+    GMutex *ready_lock;
+    gboolean ready; /**< The component is executing */
+    GstFlowReturn last_pad_push_return;
+
+    /* Output taken off the component, for the streaming thread to push. */
+    GMutex *queue_lock;
+    GCond *queue_cond;
+    GQueue *queue; /**< Buffers, then the EOS event */
+    gboolean flushing; /**< Output is dropped and nothing waits for it */
+};
+
+struct GstOmxMultiChannel
+{
+    GstElement element;
+
+    char *omx_component;
+    char *omx_library;
+    GstCaps *src_caps; /**< Set on every src pad; NULL leaves them unset */
+    guint pool_size;
+
+    GMutex *lock; /**< Protects the channel list, the pool and the scheduler state */
+    GMutex *service_lock; /**< Held while the scheduler walks the channels */
+    GList *channels;
+    GQueue *pool; /**< Loaded components, kept for the next request pad */
+    guint next_pad;
+
+    /* One thread takes the output of every channel off its component. */
+    GThread *thread;
+    GCond *cond;
+    gboolean running;
+    guint pending; /**< Output buffers queued since the last pass */
+};
+
+struct GstOmxMultiChannelClass
+{
+    GstElementClass parent_class;
+};
+
+GType gst_omx_multichannel_get_type (void);
+
+G_END_DECLS
+
+#endif /* GSTOMX_MULTICHANNEL_H */
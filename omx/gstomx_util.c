@@ -22,6 +22,7 @@
 
 #include "gstomx_util.h"
 #include <dlfcn.h>
+#include <string.h> /* for memset */
 
 #include "gstomx.h"
 
@@ -73,6 +74,9 @@ FillBufferDone (OMX_HANDLETYPE omx_handle,
 static inline const char *
 omx_error_to_str (OMX_ERRORTYPE omx_error);
 
+static inline gboolean
+error_is_recoverable (OMX_ERRORTYPE omx_error);
+
 static inline GOmxPort *
 g_omx_core_get_port (GOmxCore *core,
                      guint index);
@@ -449,6 +453,87 @@ g_omx_core_flush_stop (GOmxCore *core)
     core_for_each_port (core, g_omx_port_resume);
 }
 
+/* Loads the component just to ask what a port supports; either array
+ * may be NULL. Returns FALSE if the component couldn't be loaded. */
+gboolean
+g_omx_probe_port (const gchar *library_name,
+                  const gchar *component_name,
+                  guint port_index,
+                  GArray *profile_levels,
+                  GArray *color_formats)
+{
+    GOmxCore *core;
+    guint i;
+
+    core = g_omx_core_new ();
+    g_omx_core_init (core, library_name, component_name);
+
+    if (core->omx_state != OMX_StateLoaded)
+    {
+        GST_WARNING ("couldn't load %s to probe it", component_name);
+        g_omx_core_deinit (core);
+        g_omx_core_free (core);
+        return FALSE;
+    }
+
+    if (profile_levels)
+    {
+        OMX_VIDEO_PARAM_PROFILELEVELTYPE param;
+
+        memset (&param, 0, sizeof (param));
+        param.nSize = sizeof (OMX_VIDEO_PARAM_PROFILELEVELTYPE);
+        param.nVersion.s.nVersionMajor = 1;
+        param.nVersion.s.nVersionMinor = 1;
+
+        param.nPortIndex = port_index;
+
+        for (i = 0; i < 64; i++)
+        {
+            GOmxProfileLevel profile_level;
+
+            param.nProfileIndex = i;
+            if (OMX_GetParameter (core->omx_handle, OMX_IndexParamVideoProfileLevelQuerySupported, &param) != OMX_ErrorNone)
+                break;
+
+            profile_level.profile = param.eProfile;
+            profile_level.level = param.eLevel;
+            g_array_append_val (profile_levels, profile_level);
+        }
+    }
+
+    if (color_formats)
+    {
+        OMX_VIDEO_PARAM_PORTFORMATTYPE param;
+
+        memset (&param, 0, sizeof (param));
+        param.nSize = sizeof (OMX_VIDEO_PARAM_PORTFORMATTYPE);
+        param.nVersion.s.nVersionMajor = 1;
+        param.nVersion.s.nVersionMinor = 1;
+
+        param.nPortIndex = port_index;
+
+        for (i = 0; i < 64; i++)
+        {
+            guint color_format;
+
+            param.nIndex = i;
+            if (OMX_GetParameter (core->omx_handle, OMX_IndexParamVideoPortFormat, &param) != OMX_ErrorNone)
+                break;
+
+            if (param.eColorFormat == OMX_COLOR_FormatUnused)
+                continue;
+
+            color_format = param.eColorFormat;
+            g_array_append_val (color_formats, color_format);
+        }
+    }
+
+    g_omx_core_deinit (core);
+    g_omx_core_free (core);
+
+    return TRUE;
+}
+
 /*
  * Port
  */
@@ -776,6 +861,9 @@ out_port_cb (GOmxPort *port,
     if (!port->enabled)
         return;
 
+    if (port->core->out_buffer_cb)
+        port->core->out_buffer_cb (port);
+
 #if 0
     if (omx_buffer->nFlags & OMX_BUFFERFLAG_EOS)
     {
@@ -872,6 +960,15 @@ EventHandler (OMX_HANDLETYPE omx_handle,
             }
         case OMX_EventError:
             {
+                if (error_is_recoverable (data_1) &&
+                    core->stream_error_cb &&
+                    core->stream_error_cb (core, data_1))
+                {
+                    GST_WARNING_OBJECT (core->object, "recoverable error: %s (0x%lx)",
+                                        omx_error_to_str (data_1), data_1);
+                    break;
+                }
+
                 core->omx_error = data_1;
                 GST_ERROR_OBJECT (core->object, "unrecoverable error: %s (0x%lx)",
                                   omx_error_to_str (data_1), data_1);
@@ -902,6 +999,11 @@ EmptyBufferDone (OMX_HANDLETYPE omx_handle,
     port = g_omx_core_get_port (core, omx_buffer->nInputPortIndex);
 
     GST_CAT_LOG_OBJECT (gstomx_util_debug, core->object, "omx_buffer=%p", omx_buffer);
+
+    /* once queued, the header may be refilled at any time */
+    if (port && core->in_buffer_cb)
+        core->in_buffer_cb (port, omx_buffer);
+
     got_buffer (core, port, omx_buffer);
 
     return OMX_ErrorNone;
@@ -1047,3 +1149,17 @@ omx_error_to_str (OMX_ERRORTYPE omx_error)
             return "Unknown error";
     }
 }
+
+/* Errors about the stream data; the component keeps running. */
+static inline gboolean
+error_is_recoverable (OMX_ERRORTYPE omx_error)
+{
+    switch (omx_error)
+    {
+        case OMX_ErrorMbErrorsInFrame:
+        case OMX_ErrorStreamCorrupt:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
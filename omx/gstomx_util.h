@@ -36,10 +36,13 @@ typedef struct GOmxCore GOmxCore;
 typedef struct GOmxPort GOmxPort;
 typedef struct GOmxImp GOmxImp;
 typedef struct GOmxSymbolTable GOmxSymbolTable;
+typedef struct GOmxProfileLevel GOmxProfileLevel;
 typedef enum GOmxPortType GOmxPortType;
 
 typedef void (*GOmxCb) (GOmxCore *core);
 typedef void (*GOmxPortCb) (GOmxPort *port);
+typedef gboolean (*GOmxErrorCb) (GOmxCore *core, OMX_ERRORTYPE error);
+typedef void (*GOmxBufferCb) (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer);
 
 /* Enums. */
 
@@ -88,11 +91,20 @@ struct GOmxCore
     GSem *port_sem;
 
     GOmxCb settings_changed_cb;
+    GOmxErrorCb stream_error_cb; /**< Recoverable errors; FALSE makes them fatal. */
+    GOmxPortCb out_buffer_cb; /**< An output buffer was queued; from the component's thread. */
+    GOmxBufferCb in_buffer_cb; /**< An input buffer is done, before it's queued again. */
     GOmxImp *imp;
 
     gboolean done;
 };
 
+struct GOmxProfileLevel
+{
+    guint profile;
+    guint level; /**< Highest level supported in this profile. */
+};
+
 struct GOmxPort
 {
     GOmxCore *core;
@@ -128,6 +140,8 @@ void g_omx_core_wait_for_done (GOmxCore *core);
 void g_omx_core_flush_start (GOmxCore *core);
 void g_omx_core_flush_stop (GOmxCore *core);
 GOmxPort *g_omx_core_setup_port (GOmxCore *core, OMX_PARAM_PORTDEFINITIONTYPE *omx_port);
+gboolean g_omx_probe_port (const gchar *library_name, const gchar *component_name, guint port_index,
+                           GArray *profile_levels, GArray *color_formats);
 
 GOmxPort *g_omx_port_new (GOmxCore *core);
 void g_omx_port_free (GOmxPort *port);
@@ -24,7 +24,22 @@
 #include "gstomx_base_filter.h"
 #include "gstomx.h"
 
-#include <string.h> /* for memset */
+#include <string.h> /* for memset, memcpy */
+
+enum
+{
+    ARG_0,
+    ARG_VOLUME,
+    ARG_MUTE,
+    ARG_RAMP_TIME,
+};
+
+#define DEFAULT_VOLUME 1.0
+#define DEFAULT_MUTE FALSE
+#define DEFAULT_RAMP_TIME 0
+
+/* how often the gain moves during a ramp */
+#define RAMP_STEP (5 * GST_MSECOND)
 
 static GstOmxBaseFilterClass *parent_class;
 
@@ -101,11 +116,367 @@ type_base_init (gpointer g_class)
     }
 }
 
+static void
+set_property (GObject *obj,
+              guint prop_id,
+              const GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxVolume *self;
+
+    self = GST_OMX_VOLUME (obj);
+
+    GST_OBJECT_LOCK (self);
+    switch (prop_id)
+    {
+        case ARG_VOLUME:
+            self->volume = g_value_get_double (value);
+            self->changed = TRUE;
+            break;
+        case ARG_MUTE:
+            if (self->mute != g_value_get_boolean (value))
+            {
+                self->mute = g_value_get_boolean (value);
+                self->changed = TRUE;
+            }
+            break;
+        case ARG_RAMP_TIME:
+            self->ramp_time = g_value_get_uint64 (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+    GST_OBJECT_UNLOCK (self);
+}
+
+static void
+get_property (GObject *obj,
+              guint prop_id,
+              GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxVolume *self;
+
+    self = GST_OMX_VOLUME (obj);
+
+    GST_OBJECT_LOCK (self);
+    switch (prop_id)
+    {
+        case ARG_VOLUME:
+            g_value_set_double (value, self->volume);
+            break;
+        case ARG_MUTE:
+            g_value_set_boolean (value, self->mute);
+            break;
+        case ARG_RAMP_TIME:
+            g_value_set_uint64 (value, self->ramp_time);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+    GST_OBJECT_UNLOCK (self);
+}
+
 static void
 type_class_init (gpointer g_class,
                  gpointer class_data)
 {
+    GObjectClass *gobject_class;
+
+    gobject_class = G_OBJECT_CLASS (g_class);
+
     parent_class = g_type_class_ref (GST_OMX_BASE_FILTER_TYPE);
+
+    /* Properties stuff */
+    {
+        gobject_class->set_property = set_property;
+        gobject_class->get_property = get_property;
+
+        g_object_class_install_property (gobject_class, ARG_VOLUME,
+                                         g_param_spec_double ("volume", "Volume",
+                                                              "Volume factor, 1.0 = 100%",
+                                                              0.0, 10.0, DEFAULT_VOLUME, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_MUTE,
+                                         g_param_spec_boolean ("mute", "Mute",
+                                                               "Mute the audio",
+                                                               DEFAULT_MUTE, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_RAMP_TIME,
+                                         g_param_spec_uint64 ("ramp-time", "Ramp time",
+                                                              "Time volume and mute changes are ramped over, in nanoseconds; "
+                                                              "the 5 ms steps apply to what the component is processing then",
+                                                              0, G_MAXUINT64, DEFAULT_RAMP_TIME, G_PARAM_READWRITE));
+    }
+}
+
+static void
+setup_volume (GstOmxVolume *self,
+              gdouble gain)
+{
+    GOmxCore *gomx;
+    OMX_AUDIO_CONFIG_VOLUMETYPE config;
+    OMX_ERRORTYPE error;
+    OMX_S32 value;
+
+    gomx = GST_OMX_BASE_FILTER (self)->gomx;
+
+    memset (&config, 0, sizeof (config));
+    config.nSize = sizeof (OMX_AUDIO_CONFIG_VOLUMETYPE);
+    config.nVersion.s.nVersionMajor = 1;
+    config.nVersion.s.nVersionMinor = 1;
+
+    /* the output port's is the master volume */
+    config.nPortIndex = 1;
+    OMX_GetConfig (gomx->omx_handle, OMX_IndexConfigAudioVolume, &config);
+
+    /* linear is in percent */
+    value = (OMX_S32) (gain * 100.0 + 0.5);
+    if (config.sVolume.nMin < config.sVolume.nMax)
+        value = CLAMP (value, config.sVolume.nMin, config.sVolume.nMax);
+
+    config.bLinear = OMX_TRUE;
+    config.sVolume.nValue = value;
+
+    error = OMX_SetConfig (gomx->omx_handle, OMX_IndexConfigAudioVolume, &config);
+    if (error != OMX_ErrorNone)
+        GST_WARNING_OBJECT (self, "couldn't set volume %d: 0x%x", (gint) value, error);
+    else
+        GST_LOG_OBJECT (self, "volume %d%%", (gint) value);
+
+    self->applied_gain = gain;
+}
+
+static void
+setup_mute (GstOmxVolume *self,
+            gboolean mute)
+{
+    GOmxCore *gomx;
+    OMX_AUDIO_CONFIG_MUTETYPE config;
+    OMX_ERRORTYPE error;
+
+    gomx = GST_OMX_BASE_FILTER (self)->gomx;
+
+    memset (&config, 0, sizeof (config));
+    config.nSize = sizeof (OMX_AUDIO_CONFIG_MUTETYPE);
+    config.nVersion.s.nVersionMajor = 1;
+    config.nVersion.s.nVersionMinor = 1;
+
+    config.nPortIndex = 1;
+    config.bMute = mute ? OMX_TRUE : OMX_FALSE;
+
+    error = OMX_SetConfig (gomx->omx_handle, OMX_IndexConfigAudioMute, &config);
+    if (error != OMX_ErrorNone)
+        GST_WARNING_OBJECT (self, "couldn't set mute: 0x%x", error);
+
+    self->applied_mute = mute;
+}
+
+/* Where the ramp is at the given timestamp. */
+static void
+update_gain (GstOmxVolume *self,
+             GstClockTime timestamp)
+{
+    if (!GST_CLOCK_TIME_IS_VALID (self->ramp_end) ||
+        !GST_CLOCK_TIME_IS_VALID (timestamp) ||
+        timestamp >= self->ramp_end)
+    {
+        self->gain = self->target;
+    }
+    else if (timestamp > self->ramp_start)
+    {
+        gdouble progress;
+
+        progress = (gdouble) (timestamp - self->ramp_start) / (self->ramp_end - self->ramp_start);
+        self->gain = self->ramp_from + (self->target - self->ramp_from) * progress;
+    }
+}
+
+static void
+apply_gain (GstOmxVolume *self)
+{
+    gboolean mute;
+
+    /* muting ramps the gain down first */
+    mute = self->target_mute && self->gain == 0.0;
+
+    if (self->applied_mute != mute)
+        setup_mute (self, mute);
+
+    if (self->applied_gain != self->gain)
+        setup_volume (self, self->gain);
+}
+
+/* Bytes of input a ramp step covers; 0 when the caps don't tell. */
+static guint
+ramp_step_size (GstOmxVolume *self)
+{
+    GstCaps *caps;
+    GstStructure *structure;
+    gint rate = 0;
+    gint channels = 0;
+    guint frame_size;
+    guint size;
+
+    caps = GST_PAD_CAPS (GST_OMX_BASE_FILTER (self)->sinkpad);
+    if (!caps)
+        return 0;
+
+    structure = gst_caps_get_structure (caps, 0);
+    gst_structure_get_int (structure, "rate", &rate);
+    gst_structure_get_int (structure, "channels", &channels);
+
+    frame_size = channels * 2;
+    self->bytes_per_second = rate * frame_size;
+    if (self->bytes_per_second == 0)
+        return 0;
+
+    size = gst_util_uint64_scale_int (RAMP_STEP, self->bytes_per_second, GST_SECOND);
+    size -= size % frame_size;
+
+    return MAX (size, frame_size);
+}
+
+/* During a ramp the input goes in RAMP_STEP slices, the gain moving
+ * before each; SetConfig can only take effect on whatever the component
+ * is processing at that moment. */
+static void
+in_copy (GstOmxBaseFilter *omx_base,
+         guint8 *dest,
+         GstBuffer *buf,
+         guint offset,
+         guint size)
+{
+    GstOmxVolume *self;
+
+    self = GST_OMX_VOLUME (omx_base);
+
+    memcpy (dest, GST_BUFFER_DATA (buf) + offset, size);
+
+    update_gain (self, GST_BUFFER_TIMESTAMP (buf) +
+                 gst_util_uint64_scale_int (offset, GST_SECOND, self->bytes_per_second));
+    apply_gain (self);
+}
+
+/* Ramps advance with the buffer timestamps. */
+static void
+prepare_input (GstOmxBaseFilter *omx_base,
+               GstBuffer *buf)
+{
+    GstOmxVolume *self;
+    GstClockTime timestamp;
+    guint step_size = 0;
+
+    self = GST_OMX_VOLUME (omx_base);
+
+    timestamp = GST_BUFFER_TIMESTAMP (buf);
+
+    GST_OBJECT_LOCK (self);
+    self->target = self->mute ? 0.0 : self->volume;
+    self->target_mute = self->mute;
+    if (self->changed)
+    {
+        self->changed = FALSE;
+        self->ramp_from = self->gain;
+        self->ramp_start = timestamp;
+        if (self->ramp_time > 0 && GST_CLOCK_TIME_IS_VALID (timestamp))
+            self->ramp_end = timestamp + self->ramp_time;
+        else
+            self->ramp_end = GST_CLOCK_TIME_NONE;
+    }
+    GST_OBJECT_UNLOCK (self);
+
+    if (GST_CLOCK_TIME_IS_VALID (self->ramp_end) &&
+        GST_CLOCK_TIME_IS_VALID (timestamp) &&
+        timestamp < self->ramp_end)
+        step_size = ramp_step_size (self);
+
+    if (step_size > 0)
+    {
+        omx_base->in_slice_size = step_size;
+        omx_base->in_copy = in_copy;
+    }
+    else
+    {
+        omx_base->in_slice_size = 0;
+        omx_base->in_copy = NULL;
+
+        update_gain (self, timestamp);
+        apply_gain (self);
+    }
+}
+
+/* A fresh component has its own defaults. */
+static void
+omx_setup (GstOmxBaseFilter *omx_base)
+{
+    GstOmxVolume *self;
+
+    self = GST_OMX_VOLUME (omx_base);
+
+    self->applied_gain = -1.0;
+    self->applied_mute = -1;
+}
+
+/* Unity gain needs no component; switching back is only safe while it
+ * holds nothing, so it happens after a flush. */
+static gboolean
+can_pass_through (GstOmxVolume *self)
+{
+    gboolean ret;
+
+    GST_OBJECT_LOCK (self);
+    ret = self->volume == 1.0 && !self->mute;
+    GST_OBJECT_UNLOCK (self);
+
+    return ret;
+}
+
+static GstFlowReturn
+pad_chain (GstPad *pad,
+           GstBuffer *buf)
+{
+    GstOmxVolume *self;
+    GstOmxBaseFilter *omx_base;
+
+    self = GST_OMX_VOLUME (GST_OBJECT_PARENT (pad));
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    if (self->passthrough)
+    {
+        if (can_pass_through (self))
+            return gst_pad_push (omx_base->srcpad, buf);
+
+        GST_INFO_OBJECT (self, "leaving passthrough");
+        self->passthrough = FALSE;
+        /* ramp from unity */
+        self->gain = 1.0;
+    }
+
+    return self->base_chain (pad, buf);
+}
+
+static gboolean
+sink_event (GstPad *pad,
+            GstEvent *event)
+{
+    GstOmxVolume *self;
+    gboolean ret;
+
+    self = GST_OMX_VOLUME (GST_OBJECT_PARENT (pad));
+
+    ret = self->base_sink_event (pad, event);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP &&
+        !self->passthrough && can_pass_through (self))
+    {
+        GST_INFO_OBJECT (self, "entering passthrough");
+        self->passthrough = TRUE;
+    }
+
+    return ret;
 }
 
 static void
@@ -162,12 +533,35 @@ type_instance_init (GTypeInstance *instance,
                     gpointer g_class)
 {
     GstOmxBaseFilter *omx_base;
+    GstOmxVolume *self;
 
     omx_base = GST_OMX_BASE_FILTER (instance);
+    self = GST_OMX_VOLUME (instance);
 
     GST_DEBUG_OBJECT (omx_base, "start");
 
     omx_base->gomx->settings_changed_cb = settings_changed_cb;
+
+    omx_base->omx_setup = omx_setup;
+    omx_base->prepare_input = prepare_input;
+
+    self->base_chain = GST_PAD_CHAINFUNC (omx_base->sinkpad);
+    gst_pad_set_chain_function (omx_base->sinkpad, pad_chain);
+
+    self->base_sink_event = GST_PAD_EVENTFUNC (omx_base->sinkpad);
+    gst_pad_set_event_function (omx_base->sinkpad, sink_event);
+
+    self->volume = DEFAULT_VOLUME;
+    self->mute = DEFAULT_MUTE;
+    self->ramp_time = DEFAULT_RAMP_TIME;
+
+    self->passthrough = TRUE;
+    self->gain = DEFAULT_VOLUME;
+    self->target = DEFAULT_VOLUME;
+    self->ramp_start = GST_CLOCK_TIME_NONE;
+    self->ramp_end = GST_CLOCK_TIME_NONE;
+    self->applied_gain = -1.0;
+    self->applied_mute = -1;
 }
 
 GType
@@ -40,6 +40,26 @@ typedef struct GstOmxVolumeClass GstOmxVolumeClass;
 struct GstOmxVolume
 {
     GstOmxBaseFilter omx_base;
+
+    /* Properties; under the object lock. */
+    gdouble volume;
+    gboolean mute;
+    GstClockTime ramp_time;
+    gboolean changed; /**< A new ramp starts with the next buffer */
+
+    /* Streaming thread. */
+    gboolean passthrough; /**< Buffers go around the component */
+    gdouble gain; /**< Where the ramp is now */
+    gdouble target; /**< Where it goes; 0 when muted */
+    gboolean target_mute; /**< Mute the component once the gain is down to 0 */
+    gdouble ramp_from;
+    GstClockTime ramp_start; /**< Timestamp the ramp began at */
+    GstClockTime ramp_end; /**< Timestamp it reaches target at; NONE without a ramp */
+    guint bytes_per_second; /**< Of the input; times the ramp steps */
+    gdouble applied_gain; /**< Last set on the component; < 0 if none */
+    gint applied_mute; /**< Likewise; -1 if none */
+    GstPadChainFunction base_chain;
+    GstPadEventFunction base_sink_event;
 };
 
 struct GstOmxVolumeClass
@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <gst/check/gstcheck.h>
+#include "gstomx_convert.h"
+
+#include <string.h> /* for memcmp */
+
+#define WIDTH 37
+#define HEIGHT 11
+#define STRIDE 64
+#define SLICE_HEIGHT 16
+
+/* Y is row * 8 + column, U and V the same plus 100 and 200. */
+static guint8 *
+make_nv12 (guint *size)
+{
+    guint8 *data;
+    guint uv_width;
+    guint uv_height;
+    guint x;
+    guint y;
+
+    *size = g_omx_convert_nv12_size (STRIDE, SLICE_HEIGHT, WIDTH, HEIGHT);
+    data = g_malloc0 (*size);
+
+    uv_width = GST_ROUND_UP_2 (WIDTH) / 2;
+    uv_height = GST_ROUND_UP_2 (HEIGHT) / 2;
+
+    for (y = 0; y < HEIGHT; y++)
+        for (x = 0; x < WIDTH; x++)
+            data[y * STRIDE + x] = (y * 8 + x) & 0xff;
+
+    for (y = 0; y < uv_height; y++)
+    {
+        for (x = 0; x < uv_width; x++)
+        {
+            data[STRIDE * SLICE_HEIGHT + y * STRIDE + 2 * x] = (100 + y * 8 + x) & 0xff;
+            data[STRIDE * SLICE_HEIGHT + y * STRIDE + 2 * x + 1] = (200 + y * 8 + x) & 0xff;
+        }
+    }
+
+    return data;
+}
+
+GST_START_TEST (test_nv12_size)
+{
+    /* tight: Y plus half as much chroma */
+    fail_unless_equals_int (g_omx_convert_nv12_size (0, 0, 16, 16), 16 * 16 * 3 / 2);
+    fail_unless_equals_int (g_omx_convert_nv12_size (16, 16, 16, 16), 16 * 16 * 3 / 2);
+
+    /* the last chroma row isn't padded */
+    fail_unless_equals_int (g_omx_convert_nv12_size (STRIDE, SLICE_HEIGHT, WIDTH, HEIGHT),
+                            STRIDE * (SLICE_HEIGHT + 5) + 38);
+
+    fail_unless_equals_int (g_omx_convert_nv12_size (0, 0, 0, 0), 0);
+}
+GST_END_TEST
+
+GST_START_TEST (test_nv12_to_i420)
+{
+    guint8 *src;
+    guint8 *dest;
+    guint8 *dest_u;
+    guint8 *dest_v;
+    guint src_size;
+    guint y_stride;
+    guint uv_stride;
+    guint x;
+    guint y;
+
+    src = make_nv12 (&src_size);
+    dest = g_malloc0 (g_omx_convert_i420_size (WIDTH, HEIGHT));
+
+    /* valgrind catches anything read past src_size */
+    g_omx_convert_nv12_to_i420 (src, STRIDE, SLICE_HEIGHT, dest, WIDTH, HEIGHT);
+
+    y_stride = GST_ROUND_UP_4 (WIDTH);
+    uv_stride = GST_ROUND_UP_4 (GST_ROUND_UP_2 (WIDTH) / 2);
+    dest_u = dest + y_stride * GST_ROUND_UP_2 (HEIGHT);
+    dest_v = dest_u + uv_stride * GST_ROUND_UP_2 (HEIGHT) / 2;
+
+    for (y = 0; y < HEIGHT; y++)
+        for (x = 0; x < WIDTH; x++)
+            fail_unless_equals_int (dest[y * y_stride + x], (y * 8 + x) & 0xff);
+
+    for (y = 0; y < GST_ROUND_UP_2 (HEIGHT) / 2; y++)
+    {
+        for (x = 0; x < GST_ROUND_UP_2 (WIDTH) / 2; x++)
+        {
+            fail_unless_equals_int (dest_u[y * uv_stride + x], (100 + y * 8 + x) & 0xff);
+            fail_unless_equals_int (dest_v[y * uv_stride + x], (200 + y * 8 + x) & 0xff);
+        }
+    }
+
+    g_free (dest);
+    g_free (src);
+}
+GST_END_TEST
+
+#define CHANNELS 3
+#define FRAMES 37 /* vector runs plus a scalar tail */
+
+static const GOmxPcmFormat pcm_formats[] = {
+    { GOMX_PCM_S16, G_LITTLE_ENDIAN, FALSE },
+    { GOMX_PCM_S16, G_BIG_ENDIAN, FALSE },
+    { GOMX_PCM_S32, G_LITTLE_ENDIAN, FALSE },
+    { GOMX_PCM_S32, G_BIG_ENDIAN, FALSE },
+    { GOMX_PCM_F32, G_LITTLE_ENDIAN, FALSE },
+    { GOMX_PCM_F32, G_BIG_ENDIAN, FALSE },
+};
+
+/* Samples across the whole range, with the extremes, and for floats
+ * some out of range and some halfway between two 16-bit values. */
+static guint8 *
+make_pcm (const GOmxPcmFormat *format,
+          guint n)
+{
+    guint8 *data;
+    guint width;
+    guint i;
+
+    width = g_omx_convert_pcm_width (format);
+    data = g_malloc (n * width);
+
+    for (i = 0; i < n; i++)
+    {
+        guint8 *p;
+        guint32 v;
+
+        p = data + i * width;
+
+        switch (format->type)
+        {
+            case GOMX_PCM_S16:
+                v = i < 2 ? 0x7fff + i : (i * 7919) & 0xffff;
+                break;
+            case GOMX_PCM_S32:
+                v = i < 2 ? 0x7fffffff + i : i * 2654435761u;
+                break;
+            default:
+                {
+                    union { guint32 bits; gfloat f; } u;
+
+                    if (i % 3 == 0)
+                        u.f = ((gint) i - (gint) n / 2 + 0.5f) / 32768.0f;
+                    else
+                        u.f = ((gint) i - (gint) n / 2) * (2.4f / n);
+                    v = u.bits;
+                }
+                break;
+        }
+
+        if (width == 2)
+        {
+            if (format->endianness == G_LITTLE_ENDIAN)
+                GST_WRITE_UINT16_LE (p, v);
+            else
+                GST_WRITE_UINT16_BE (p, v);
+        }
+        else
+        {
+            if (format->endianness == G_LITTLE_ENDIAN)
+                GST_WRITE_UINT32_LE (p, v);
+            else
+                GST_WRITE_UINT32_BE (p, v);
+        }
+    }
+
+    return data;
+}
+
+/* One sample at a time never takes the vector paths. */
+static void
+check_vector_matches_scalar (const GOmxPcmFormat *src_format,
+                             const GOmxPcmFormat *dest_format)
+{
+    guint8 *src;
+    guint8 *vector;
+    guint8 *scalar;
+    guint src_width;
+    guint dest_width;
+    guint i;
+
+    src_width = g_omx_convert_pcm_width (src_format);
+    dest_width = g_omx_convert_pcm_width (dest_format);
+
+    src = make_pcm (src_format, CHANNELS * FRAMES);
+    vector = g_malloc0 (CHANNELS * FRAMES * dest_width);
+    scalar = g_malloc0 (CHANNELS * FRAMES * dest_width);
+
+    g_omx_convert_pcm (src, src_format, vector, dest_format, CHANNELS, FRAMES, NULL);
+
+    for (i = 0; i < CHANNELS * FRAMES; i++)
+        g_omx_convert_pcm (src + i * src_width, src_format,
+                           scalar + i * dest_width, dest_format, 1, 1, NULL);
+
+    fail_unless (memcmp (vector, scalar, CHANNELS * FRAMES * dest_width) == 0,
+                 "type %d, endianness %d to type %d, endianness %d differs",
+                 src_format->type, src_format->endianness,
+                 dest_format->type, dest_format->endianness);
+
+    g_free (scalar);
+    g_free (vector);
+    g_free (src);
+}
+
+GST_START_TEST (test_pcm_vector_matches_scalar)
+{
+    guint a;
+    guint b;
+
+    for (a = 0; a < G_N_ELEMENTS (pcm_formats); a++)
+        for (b = 0; b < G_N_ELEMENTS (pcm_formats); b++)
+            check_vector_matches_scalar (&pcm_formats[a], &pcm_formats[b]);
+}
+GST_END_TEST
+
+GST_START_TEST (test_pcm_f32_to_s16)
+{
+    static const gfloat in[] = {
+        0.5f / 32768, -0.5f / 32768, 1.5f / 32768, -1.5f / 32768,
+        0.25f, -0.25f, 1.0f, -1.0f, 2.0f, -2.0f, 1e10f, -0.0f,
+    };
+    static const gint16 out[] = {
+        1, -1, 2, -2,
+        8192, -8192, 32767, -32768, 32767, -32768, 32767, 0,
+    };
+    GOmxPcmFormat f32 = { GOMX_PCM_F32, G_BYTE_ORDER, FALSE };
+    GOmxPcmFormat s16 = { GOMX_PCM_S16, G_BYTE_ORDER, FALSE };
+    gint16 dest[G_N_ELEMENTS (in)];
+    guint i;
+
+    /* rounded to nearest, halves away from zero, saturated */
+    g_omx_convert_pcm ((const guint8 *) in, &f32, (guint8 *) dest, &s16, 1, G_N_ELEMENTS (in), NULL);
+
+    for (i = 0; i < G_N_ELEMENTS (in); i++)
+        fail_unless_equals_int (dest[i], out[i]);
+}
+GST_END_TEST
+
+GST_START_TEST (test_pcm_byte_swap)
+{
+    guint a;
+
+    /* little endian ones, and the big endian one after each */
+    for (a = 0; a < G_N_ELEMENTS (pcm_formats); a += 2)
+    {
+        const GOmxPcmFormat *le = &pcm_formats[a];
+        const GOmxPcmFormat *be = &pcm_formats[a + 1];
+        guint8 *src;
+        guint8 *dest;
+        guint width;
+        guint i;
+        guint j;
+
+        width = g_omx_convert_pcm_width (le);
+        src = make_pcm (le, CHANNELS * FRAMES);
+        dest = g_malloc0 (CHANNELS * FRAMES * width);
+
+        g_omx_convert_pcm (src, le, dest, be, CHANNELS, FRAMES, NULL);
+
+        for (i = 0; i < CHANNELS * FRAMES; i++)
+            for (j = 0; j < width; j++)
+                fail_unless_equals_int (dest[i * width + j], src[i * width + width - 1 - j]);
+
+        g_free (dest);
+        g_free (src);
+    }
+}
+GST_END_TEST
+
+GST_START_TEST (test_pcm_planar)
+{
+    GOmxPcmFormat interleaved = { GOMX_PCM_S16, G_BYTE_ORDER, FALSE };
+    GOmxPcmFormat planar = { GOMX_PCM_S16, G_BYTE_ORDER, TRUE };
+    gint16 src[CHANNELS * FRAMES];
+    gint16 dest[CHANNELS * FRAMES];
+    gint16 back[CHANNELS * FRAMES];
+    guint c;
+    guint i;
+
+    for (i = 0; i < FRAMES; i++)
+        for (c = 0; c < CHANNELS; c++)
+            src[i * CHANNELS + c] = c * 1000 + i;
+
+    g_omx_convert_pcm ((const guint8 *) src, &interleaved, (guint8 *) dest, &planar,
+                       CHANNELS, FRAMES, NULL);
+
+    for (c = 0; c < CHANNELS; c++)
+        for (i = 0; i < FRAMES; i++)
+            fail_unless_equals_int (dest[c * FRAMES + i], c * 1000 + i);
+
+    g_omx_convert_pcm ((const guint8 *) dest, &planar, (guint8 *) back, &interleaved,
+                       CHANNELS, FRAMES, NULL);
+
+    fail_unless (memcmp (back, src, sizeof (src)) == 0);
+}
+GST_END_TEST
+
+GST_START_TEST (test_pcm_channel_map)
+{
+    static const guint map[CHANNELS] = { 2, 0, 1 };
+    GOmxPcmFormat s16 = { GOMX_PCM_S16, G_BYTE_ORDER, FALSE };
+    GOmxPcmFormat s32 = { GOMX_PCM_S32, G_BYTE_ORDER, FALSE };
+    gint16 src[CHANNELS * FRAMES];
+    gint32 dest[CHANNELS * FRAMES];
+    guint c;
+    guint i;
+
+    for (i = 0; i < FRAMES; i++)
+        for (c = 0; c < CHANNELS; c++)
+            src[i * CHANNELS + c] = c * 1000 + i;
+
+    /* dest channel c comes from src channel map[c] */
+    g_omx_convert_pcm ((const guint8 *) src, &s16, (guint8 *) dest, &s32,
+                       CHANNELS, FRAMES, map);
+
+    for (i = 0; i < FRAMES; i++)
+        for (c = 0; c < CHANNELS; c++)
+            fail_unless_equals_int (dest[i * CHANNELS + c], (gint32) (map[c] * 1000 + i) * 65536);
+}
+GST_END_TEST
+
+static Suite *
+convert_suite (void)
+{
+    Suite *s = suite_create ("convert");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_add_test (tc_chain, test_nv12_size);
+    tcase_add_test (tc_chain, test_nv12_to_i420);
+    tcase_add_test (tc_chain, test_pcm_vector_matches_scalar);
+    tcase_add_test (tc_chain, test_pcm_f32_to_s16);
+    tcase_add_test (tc_chain, test_pcm_byte_swap);
+    tcase_add_test (tc_chain, test_pcm_planar);
+    tcase_add_test (tc_chain, test_pcm_channel_map);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (convert);
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2009 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <gst/check/gstcheck.h>
+
+#define BUFFER_SIZE 0x100
+#define BUFFER_COUNT 0x20
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+typedef struct
+{
+    GstPad *request_pad;
+    GstPad *srcpad; /**< Feeds the request pad */
+    GstPad *sinkpad; /**< Gets the channel's output */
+    guint count;
+    gboolean eos;
+    gboolean blocked; /**< The sink holds the streaming thread */
+} Channel;
+
+static GMutex *lock;
+static GCond *cond;
+
+static GstFlowReturn
+test_chain (GstPad *pad,
+            GstBuffer *buf)
+{
+    Channel *channel;
+
+    channel = gst_pad_get_element_private (pad);
+
+    g_mutex_lock (lock);
+    while (channel->blocked)
+        g_cond_wait (cond, lock);
+    fail_unless (GST_BUFFER_DATA (buf)[0] == channel->count);
+    channel->count++;
+    g_cond_broadcast (cond);
+    g_mutex_unlock (lock);
+
+    gst_buffer_unref (buf);
+
+    return GST_FLOW_OK;
+}
+
+static gboolean
+test_sink_event (GstPad *pad,
+                 GstEvent *event)
+{
+    Channel *channel;
+
+    channel = gst_pad_get_element_private (pad);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+    {
+        g_mutex_lock (lock);
+        channel->eos = TRUE;
+        g_cond_broadcast (cond);
+        g_mutex_unlock (lock);
+    }
+
+    gst_event_unref (event);
+
+    return TRUE;
+}
+
+static void
+channel_setup (Channel *channel,
+               GstElement *filter)
+{
+    GstPad *pad;
+    gchar *name;
+
+    channel->request_pad = gst_element_get_request_pad (filter, "sink_%d");
+    fail_unless (channel->request_pad != NULL);
+
+    channel->srcpad = gst_pad_new_from_static_template (&srctemplate, "src");
+    fail_unless (gst_pad_link (channel->srcpad, channel->request_pad) == GST_PAD_LINK_OK);
+
+    name = g_strdup_printf ("src_%s", GST_PAD_NAME (channel->request_pad) + strlen ("sink_"));
+    pad = gst_element_get_static_pad (filter, name);
+    g_free (name);
+    fail_unless (pad != NULL);
+
+    channel->sinkpad = gst_pad_new_from_static_template (&sinktemplate, "sink");
+    gst_pad_set_element_private (channel->sinkpad, channel);
+    gst_pad_set_chain_function (channel->sinkpad, test_chain);
+    gst_pad_set_event_function (channel->sinkpad, test_sink_event);
+    fail_unless (gst_pad_link (pad, channel->sinkpad) == GST_PAD_LINK_OK);
+    gst_object_unref (pad);
+
+    gst_pad_set_active (channel->srcpad, TRUE);
+    gst_pad_set_active (channel->sinkpad, TRUE);
+}
+
+static void
+channel_teardown (Channel *channel,
+                  GstElement *filter)
+{
+    gst_pad_set_active (channel->srcpad, FALSE);
+    gst_pad_set_active (channel->sinkpad, FALSE);
+
+    gst_element_release_request_pad (filter, channel->request_pad);
+    gst_object_unref (channel->request_pad);
+    gst_object_unref (channel->srcpad);
+    gst_object_unref (channel->sinkpad);
+}
+
+static void
+push_buffers (Channel *channel)
+{
+    guint i;
+
+    for (i = 0; i < BUFFER_COUNT; i++)
+    {
+        GstBuffer *buf;
+
+        buf = gst_buffer_new_and_alloc (BUFFER_SIZE);
+        GST_BUFFER_DATA (buf)[0] = i;
+        fail_unless (gst_pad_push (channel->srcpad, buf) == GST_FLOW_OK);
+    }
+
+    fail_unless (gst_pad_push_event (channel->srcpad, gst_event_new_eos ()));
+}
+
+static gpointer
+push_thread (gpointer data)
+{
+    push_buffers (data);
+
+    return NULL;
+}
+
+static void
+wait_eos (Channel *channel)
+{
+    g_mutex_lock (lock);
+    while (!channel->eos)
+        g_cond_wait (cond, lock);
+    g_mutex_unlock (lock);
+}
+
+/* A sink holding its channel's streaming thread mustn't stall the
+ * others. */
+GST_START_TEST (test_blocked_channel)
+{
+    GstElement *filter;
+    Channel channels[2];
+    GThread *thread;
+
+    lock = g_mutex_new ();
+    cond = g_cond_new ();
+    memset (channels, 0, sizeof (channels));
+
+    filter = gst_check_setup_element ("omx_multichannel");
+    g_object_set (G_OBJECT (filter), "library-name", "libomxil-foo.so", NULL);
+
+    channel_setup (&channels[0], filter);
+    channel_setup (&channels[1], filter);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    channels[0].blocked = TRUE;
+    thread = g_thread_create (push_thread, &channels[0], TRUE, NULL);
+
+    push_buffers (&channels[1]);
+    wait_eos (&channels[1]);
+    fail_unless_equals_int (channels[1].count, BUFFER_COUNT);
+
+    g_mutex_lock (lock);
+    fail_if (channels[0].eos);
+    channels[0].blocked = FALSE;
+    g_cond_broadcast (cond);
+    g_mutex_unlock (lock);
+
+    g_thread_join (thread);
+    wait_eos (&channels[0]);
+    fail_unless_equals_int (channels[0].count, BUFFER_COUNT);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_NULL),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    channel_teardown (&channels[0], filter);
+    channel_teardown (&channels[1], filter);
+    gst_check_teardown_element (filter);
+
+    g_cond_free (cond);
+    g_mutex_free (lock);
+}
+GST_END_TEST
+
+static Suite *
+multichannel_suite (void)
+{
+    Suite *s = suite_create ("multichannel");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_set_timeout (tc_chain, 10);
+    tcase_add_test (tc_chain, test_blocked_channel);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (multichannel);